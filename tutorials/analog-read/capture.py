@@ -0,0 +1,121 @@
+import os
+import sys
+import time
+import struct
+import argparse
+import serial
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'common'))
+import packet
+
+
+# Same as main-capture.c
+TYPE_START = 0x01
+TYPE_STOP = 0x02
+TYPE_BLOCK = 0x10
+TYPE_NACK = 0x7f
+TYPE_ANSWER = 0x80
+
+FORMAT_10_BITS = 0
+FORMAT_8_BITS = 1
+
+CLOCKS = { 128 : 0, 32 : 1, 16 : 2 }
+
+# Blocks sent and dropped, followed by the reception error counters
+COUNTERS_FORMAT = '<HH'
+
+
+def unpack_10_bits(data):
+    # 4 samples in 5 bytes : their 8 highest bits, then their 2 lowest bits
+    samples = []
+    for i in range(0, len(data) // 5 * 5, 5):
+        low = data[i + 4]
+        samples.extend((data[i + j] << 2) | ((low >> (2 * j)) & 0x03) for j in range(4))
+    return samples
+
+
+def main():
+    # Command line arguments
+    parser = argparse.ArgumentParser(description = 'Capture the samples streamed by the analog-read capture program to a file')
+    parser.add_argument('--port', default = '/dev/ttyUSB0')
+    parser.add_argument('--baud', type = int, default = 1000000, help = 'as CAPTURE_BAUD in main-capture.c')
+    parser.add_argument('--channel', type = int, default = 0, help = 'analog input, 0 to 7, or 14 for the bandgap')
+    parser.add_argument('--clock', type = int, choices = sorted(CLOCKS), default = 32, help = 'ADC clock prescaler')
+    parser.add_argument('--bits', type = int, choices = (8, 10), default = 8, help = 'sample size, 10 bits are only accurate with a prescaler of 128')
+    parser.add_argument('--rate', type = int, default = 20000, help = 'samples per second')
+    parser.add_argument('--duration', type = float, default = 1., help = 'seconds')
+    parser.add_argument('output_path', help = 'raw samples, 1 byte each in 8 bits, 2 bytes little endian in 10 bits')
+
+    args = parser.parse_args()
+
+    format = FORMAT_8_BITS if args.bits == 8 else FORMAT_10_BITS
+    setup = struct.pack('<BBBH', args.channel, CLOCKS[args.clock], format, args.rate)
+
+    with serial.Serial(args.port, args.baud, timeout = .05) as port, open(args.output_path, 'wb') as output:
+        # Opening the port resets the Arduino
+        time.sleep(2.)
+        port.reset_input_buffer()
+        link = packet.Link(port)
+
+        # Start, blocks may come right behind the answer
+        link.send(TYPE_START, setup)
+        answer = link.receive(1.)
+        if answer is None or answer[0] != TYPE_START | TYPE_ANSWER:
+            sys.exit(f'capture refused, check the rate for the clock : {answer}')
+        rate, block_samples = struct.unpack('<HB', answer[1])
+        print(f'{rate} samples per second, {block_samples} samples per block', file = sys.stderr)
+
+        # Blocks, until the duration is over, then until the stop answer
+        expected, received, dropped, sample_count = 0, 0, 0, 0
+        counters = None
+        start = time.monotonic()
+        stop_sent = False
+        while counters is None:
+            if not stop_sent and time.monotonic() - start >= args.duration:
+                link.send(TYPE_STOP)
+                stop_sent = True
+
+            answer = link.receive(1.)
+            if answer is None:
+                if stop_sent:
+                    break
+                continue
+
+            type, payload = answer
+            if type == TYPE_STOP | TYPE_ANSWER:
+                counters = struct.unpack_from(COUNTERS_FORMAT, payload)
+                continue
+            if type != TYPE_BLOCK:
+                continue
+
+            # A gap in the sequence numbers is a block lost on the way, or
+            # dropped by the Arduino when samples were lost
+            sequence = struct.unpack_from('<H', payload)[0]
+            gap = (sequence - expected) & 0xffff
+            if gap:
+                print(f'{gap} block(s) dropped after sample {sample_count}', file = sys.stderr)
+                dropped += gap
+            expected = (sequence + 1) & 0xffff
+            received += 1
+
+            data = payload[2:]
+            if format == FORMAT_8_BITS:
+                output.write(data)
+                sample_count += len(data)
+            else:
+                samples = unpack_10_bits(data)
+                output.write(struct.pack(f'<{len(samples)}H', *samples))
+                sample_count += len(samples)
+
+    # Report
+    elapsed = time.monotonic() - start
+    print(f'{sample_count} samples in {received} blocks, {dropped} block(s) dropped, {link.errors} corrupted packet(s), {elapsed:.2f} sec', file = sys.stderr)
+    if counters is None:
+        print('no answer to the stop request', file = sys.stderr)
+    else:
+        sent, not_sent = counters
+        print(f'Arduino : {sent} block(s) sent, {sent - received} lost on the way, {not_sent} dropped for lack of time', file = sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
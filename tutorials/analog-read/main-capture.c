@@ -0,0 +1,254 @@
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+
+#include "adc.h"
+#include "packet.h"
+#include "uart.h"
+
+
+// Both sides switch to this rate right away, it divides 1 MHz thus it is
+// exact. 100000 bytes per second.
+#ifndef CAPTURE_BAUD
+#define CAPTURE_BAUD 1000000UL
+#endif
+
+
+// --- Packet types -----------------------------------------------------------
+//
+// Answers have the request's type with the highest bit set
+
+#define TYPE_START 0x01 // Channel, clock, format, rate, see struct capture_setup
+#define TYPE_STOP  0x02 // Answered with the counters, see struct capture_counters
+#define TYPE_BLOCK 0x10 // Sent while capturing, see struct capture_block
+#define TYPE_NACK  0x7f // Unknown or malformed request, payload is its type
+
+#define TYPE_ANSWER 0x80
+
+// Sample formats
+#define FORMAT_10_BITS 0 // 4 samples in 5 bytes
+#define FORMAT_8_BITS  1 // 1 sample per byte, left adjusted conversions
+
+// Clocks, as in the START packet
+#define CLOCK_DIV_128 0
+#define CLOCK_DIV_32  1
+#define CLOCK_DIV_16  2
+
+// Block payload, the largest that fits in a packet with its sequence number
+#define BLOCK_DATA_SIZE 60
+#define BLOCK_MAX_SAMPLES BLOCK_DATA_SIZE
+
+_Static_assert(BLOCK_DATA_SIZE + 2 <= PACKET_MAX_PAYLOAD, "BLOCK_DATA_SIZE does not fit in a packet");
+_Static_assert(BLOCK_MAX_SAMPLES <= ADC_RING_SIZE / 2, "a block should fit twice in the ring");
+
+
+// All fields little endian, without padding on the AVR
+struct capture_setup {
+	uint8_t channel;
+	uint8_t clock;   // One of CLOCK_*
+	uint8_t format;  // One of FORMAT_*
+	uint16_t rate;   // Samples per second
+};
+
+struct capture_answer {
+	uint16_t rate;          // Actual rate, from the timer setting
+	uint8_t block_samples;  // Samples per block
+};
+
+struct capture_block {
+	uint16_t sequence;      // Blocks since the START, sent or not
+	uint8_t data[BLOCK_DATA_SIZE];
+};
+
+struct capture_counters {
+	uint16_t sent;          // Blocks sent
+	uint16_t dropped;       // Blocks not sent, samples were lost
+	struct uart_errors uart;
+	struct packet_errors packet;
+};
+
+
+static const __flash uint8_t clocks[] = {
+	ADC_CLOCK_DIV_128,
+	ADC_CLOCK_DIV_32,
+	ADC_CLOCK_DIV_16
+};
+
+static struct capture_setup setup;
+static uint8_t capturing;
+static uint8_t block_samples;
+static struct capture_block block;
+static struct capture_counters counters;
+
+
+// --- Sample packing ---------------------------------------------------------
+
+// 4 samples of 10 bits in 5 bytes: their 8 highest bits, then their 2 lowest
+// bits, the first sample in the lowest bits. Returns the bytes written.
+static uint8_t
+pack_10_bits(const uint16_t* samples, uint8_t count, uint8_t* out) {
+	uint8_t* ptr = out;
+	for(uint8_t i = 0; i < count; i += 4, samples += 4) {
+		uint8_t low = 0;
+		for(uint8_t j = 0; j < 4; ++j) {
+			*ptr++ = samples[j] >> 2;
+			low |= (samples[j] & 0x03) << (2 * j);
+		}
+		*ptr++ = low;
+	}
+
+	// Job done
+	return ptr - out;
+}
+
+
+// Left adjusted conversions, the 8 bits sample is the high byte
+static uint8_t
+pack_8_bits(const uint16_t* samples, uint8_t count, uint8_t* out) {
+	for(uint8_t i = 0; i < count; ++i)
+		out[i] = samples[i] >> 8;
+
+	return count;
+}
+
+
+// --- Capture ----------------------------------------------------------------
+
+// Starts the acquisition with an empty ring, returns 0 if the rate is out of
+// range for the clock
+static uint8_t
+capture_start(void) {
+	uint8_t channel = setup.channel & 0x0f;
+	if (setup.format == FORMAT_8_BITS)
+		channel |= ADC_LEFT_ADJUST;
+
+	if (!adc_start(channel, setup.rate))
+		return 0;
+
+	struct adc_stats stats;
+	adc_get_stats(&stats);
+
+	// Job done
+	return 1;
+}
+
+
+static void
+send_block(void) {
+	uint16_t samples[BLOCK_MAX_SAMPLES];
+	adc_read_block(samples, block_samples);
+
+	// Samples were lost while the ring was full: drop this block and what
+	// is left in the ring, then restart with an empty ring. The sequence
+	// skips about as many blocks as samples were lost.
+	struct adc_stats stats;
+	adc_get_stats(&stats);
+	if (stats.overruns) {
+		uint16_t skipped = (stats.overruns + ADC_RING_SIZE) / block_samples;
+		block.sequence += skipped;
+		counters.dropped += skipped;
+		capture_start();
+		return;
+	}
+
+	uint8_t size;
+	if (setup.format == FORMAT_8_BITS)
+		size = pack_8_bits(samples, block_samples, block.data);
+	else
+		size = pack_10_bits(samples, block_samples, block.data);
+
+	// Queued while the next block is being converted
+	packet_send(TYPE_BLOCK, &block, sizeof(block.sequence) + size);
+	block.sequence += 1;
+	counters.sent += 1;
+}
+
+
+// --- Packet handlers --------------------------------------------------------
+
+static void
+nack(const struct packet* packet) {
+	packet_send(TYPE_NACK, &packet->type, 1);
+}
+
+
+static void
+on_start(const struct packet* packet) {
+	adc_stop();
+	capturing = 0;
+
+	const struct capture_setup* request = (const struct capture_setup*)packet->payload;
+	if ((packet->length != sizeof(setup)) || (request->clock >= sizeof(clocks)) || (request->format > FORMAT_8_BITS)) {
+		nack(packet);
+		return;
+	}
+
+	// Whole groups of 4 samples in 10 bits
+	setup = *request;
+	block_samples = (setup.format == FORMAT_8_BITS) ? BLOCK_DATA_SIZE : BLOCK_DATA_SIZE / 5 * 4;
+
+	block.sequence = 0;
+	counters.sent = 0;
+	counters.dropped = 0;
+	uart_get_errors(&counters.uart);
+	packet_get_errors(&counters.packet);
+
+	adc_set_clock(clocks[setup.clock]);
+	if (!capture_start()) {
+		nack(packet);
+		return;
+	}
+	capturing = 1;
+
+	// The first block is sent after the answer
+	struct capture_answer answer = { F_CPU / 8 / (F_CPU / 8 / setup.rate), block_samples };
+	packet_send(TYPE_START | TYPE_ANSWER, &answer, sizeof(answer));
+}
+
+
+static void
+on_stop(const struct packet* packet) {
+	(void)packet;
+
+	adc_stop();
+	capturing = 0;
+
+	uart_get_errors(&counters.uart);
+	packet_get_errors(&counters.packet);
+	packet_send(TYPE_STOP | TYPE_ANSWER, &counters, sizeof(counters));
+}
+
+
+static const __flash struct packet_handler handlers[] = {
+	{ TYPE_START, on_start },
+	{ TYPE_STOP,  on_stop },
+};
+
+
+// --- Main entry point -------------------------------------------------------
+
+int
+main(void) {
+	// Setup, the serial link at full speed right away
+	uart_init();
+	uart_set_baud(CAPTURE_BAUD);
+	packet_init();
+	adc_init();
+	sei();
+
+	// Main loop, a block at a time while capturing, requests in between
+	while(1) {
+		struct packet packet;
+		if (capturing) {
+			if (!packet_try_receive(&packet)) {
+				send_block();
+				continue;
+			}
+		}
+		else
+			packet_receive(&packet);
+
+		if (!packet_dispatch(&packet, handlers, sizeof(handlers) / sizeof(handlers[0])))
+			nack(&packet);
+	}
+}
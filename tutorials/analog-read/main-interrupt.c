@@ -32,6 +32,13 @@ setup_adc(uint8_t channel)  {
 
 	// Enable ADC ready interrupt
 	ADCSRA |= _BV(ADIE);
+
+	// Free running mode, each conversion starts the next one
+	ADCSRB &= ~(_BV(ADTS2) | _BV(ADTS1) | _BV(ADTS0));
+	ADCSRA |= _BV(ADATE);
+
+	// Start the first conversion
+	ADCSRA |= _BV(ADSC);
 }
 
 
@@ -35,8 +35,8 @@ main(void) {
 		// Initiate an ADC read
 		ADCSRA |= _BV(ADSC);
 		
-		// Wait for the ADC read to be completed
-		while((ADCSRA & _BV(ADSC)) == 1);
+		// Wait for the ADC read to be completed, ADSC goes back to 0
+		while(ADCSRA & _BV(ADSC));
 		
 		// Read the ADC result
 		if (ADCW > 682)
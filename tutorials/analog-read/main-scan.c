@@ -0,0 +1,79 @@
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+
+#include <stdio.h>
+
+#include "adc.h"
+#include "uart.h"
+
+
+// 8 slots per scan, the supply channel needs one more to settle: 300 Hz for
+// each channel
+#define CONVERSION_RATE 2400
+
+// 33 msec of samples, a report every 30 blocks
+#define BLOCK_SIZE 10
+#define REPORT_BLOCK_COUNT 30
+
+_Static_assert(BLOCK_SIZE <= ADC_RING_SIZE / 2, "BLOCK_SIZE should fit twice in the ring");
+
+
+// Analog inputs 0 to 5, then the 1.1 V bandgap against AVcc, for the supply
+#define INPUT_COUNT 6
+#define CHANNEL_COUNT (INPUT_COUNT + 1)
+
+static struct adc_channel channels[CHANNEL_COUNT] = {
+	{ .admux = ADC_REF_AVCC | 0 },
+	{ .admux = ADC_REF_AVCC | 1 },
+	{ .admux = ADC_REF_AVCC | 2 },
+	{ .admux = ADC_REF_AVCC | 3 },
+	{ .admux = ADC_REF_AVCC | 4 },
+	{ .admux = ADC_REF_AVCC | 5 },
+	{ .admux = ADC_REF_AVCC | ADC_BANDGAP, .settle = 1 }
+};
+
+
+// --- Main entry point -------------------------------------------------------
+
+int
+main(void) {
+	// Setup
+	uart_init();
+	adc_init();
+	sei();
+
+	uint16_t channel_rate = adc_scan_start(channels, CHANNEL_COUNT, CONVERSION_RATE);
+	fprintf(&uart_output, "---[ Arduino ADC scan, %u channels at %u Hz ]---\r\n", CHANNEL_COUNT, channel_rate);
+	fputs("  A0   A1   A2   A3   A4   A5  Vcc samples/s overruns\r\n", &uart_output);
+
+	// Main loop, the channels fill up at the same pace
+	uint32_t sums[CHANNEL_COUNT] = { 0 };
+	for(uint8_t block = 1; ; ++block) {
+		for(uint8_t i = 0; i < CHANNEL_COUNT; ++i) {
+			uint16_t samples[BLOCK_SIZE];
+			adc_read_channel(&channels[i], samples, BLOCK_SIZE);
+			for(uint8_t j = 0; j < BLOCK_SIZE; ++j)
+				sums[i] += samples[j];
+		}
+
+		if (block != REPORT_BLOCK_COUNT)
+			continue;
+
+		// Means of the last second, in less time than it takes to fill a ring
+		for(uint8_t i = 0; i < INPUT_COUNT; ++i)
+			fprintf(&uart_output, "%4u ", (uint16_t)(sums[i] / (BLOCK_SIZE * REPORT_BLOCK_COUNT)));
+
+		// 1.1 V reads as 1100 * 1024 / Vcc, in mV
+		uint32_t bandgap_sum = sums[INPUT_COUNT];
+		uint16_t vcc = bandgap_sum ? 1100UL * 1024 * BLOCK_SIZE * REPORT_BLOCK_COUNT / bandgap_sum : 0;
+
+		struct adc_stats stats;
+		adc_get_stats(&stats);
+		fprintf(&uart_output, "%4u %9u %8u\r\n", vcc, stats.samples, stats.overruns);
+
+		block = 0;
+		for(uint8_t i = 0; i < CHANNEL_COUNT; ++i)
+			sums[i] = 0;
+	}
+}
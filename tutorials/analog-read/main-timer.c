@@ -0,0 +1,90 @@
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+
+#include <stdio.h>
+
+#include "adc.h"
+#include "dsp.h"
+#include "uart.h"
+
+
+#define SAMPLE_RATE 1000
+
+// 10 msec of samples, a report every 100 blocks
+#define BLOCK_SIZE (SAMPLE_RATE / 100)
+#define REPORT_BLOCK_COUNT 100
+
+_Static_assert((BLOCK_SIZE >= 1) && (BLOCK_SIZE <= ADC_RING_SIZE / 2), "BLOCK_SIZE should fit twice in the ring");
+
+// Low-pass at about 5 Hz, 256 * 2 * pi * 5 / 1000
+#define SMOOTHING_ALPHA 8
+
+// 2/3 of the range, R1 half of R2 on the voltage divider, give or take 20
+#define THRESHOLD_LOW  662
+#define THRESHOLD_HIGH 702
+
+
+// --- Main entry point -------------------------------------------------------
+
+int
+main(void) {
+	// Setup
+	uart_init();
+	adc_init();
+	sei();
+
+	// Set pin 5 of PORT B for write operations
+	DDRB |= _BV(DDB5);
+
+	// The led follows the smoothed input, with hysteresis
+	struct dsp_iir1 smoothing;
+	dsp_iir1_init(&smoothing, SMOOTHING_ALPHA, adc_read(0));
+	struct dsp_schmitt threshold = { THRESHOLD_LOW, THRESHOLD_HIGH, 0 };
+
+	// Acquisition of channel 0 at SAMPLE_RATE
+	fprintf(&uart_output, "---[ Arduino ADC, %u Hz ]---\r\n", SAMPLE_RATE);
+	fputs("mean  min  max samples overruns\r\n", &uart_output);
+	adc_start(0, SAMPLE_RATE);
+
+	// Main loop, woken up once per block
+	uint16_t min = 0xffff, max = 0;
+	uint32_t sum = 0;
+	for(uint8_t block = 1; ; ++block) {
+		uint16_t samples[BLOCK_SIZE];
+		adc_read_block(samples, BLOCK_SIZE);
+
+		uint16_t block_sum = 0;
+		for(uint8_t i = 0; i < BLOCK_SIZE; ++i) {
+			if (samples[i] < min)
+				min = samples[i];
+			if (samples[i] > max)
+				max = samples[i];
+			block_sum += samples[i];
+		}
+		sum += block_sum;
+
+		// Led on above 2/3 of the range, as the other examples, without
+		// blinking when the input is right at the threshold
+		int16_t* filtered = (int16_t*)samples;
+		dsp_iir1(&smoothing, filtered, BLOCK_SIZE);
+		if (dsp_schmitt(&threshold, filtered, BLOCK_SIZE))
+			PORTB |= _BV(PORTB5);
+		else
+			PORTB &= ~_BV(PORTB5);
+
+		if (block != REPORT_BLOCK_COUNT)
+			continue;
+
+		// Report, in less time than it takes to fill the ring
+		struct adc_stats stats;
+		adc_get_stats(&stats);
+		fprintf(&uart_output, "%4u %4u %4u %5u %u\r\n",
+			(uint16_t)(sum / (BLOCK_SIZE * REPORT_BLOCK_COUNT)), min, max, stats.samples, stats.overruns);
+
+		block = 0;
+		min = 0xffff;
+		max = 0;
+		sum = 0;
+	}
+}
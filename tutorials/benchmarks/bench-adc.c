@@ -0,0 +1,126 @@
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+#include <stdio.h>
+
+#include "adc.h"
+#include "cycles.h"
+#include "uart.h"
+
+
+// The 1.1 V bandgap against AVcc needs no wiring. Set to an analog input to
+// measure a signal of your own.
+#ifndef BENCH_CHANNEL
+#define BENCH_CHANNEL ADC_BANDGAP
+#endif
+
+#define OUTPUT_COUNT 64
+
+static uint16_t outputs[OUTPUT_COUNT];
+
+
+// --- Statistics -------------------------------------------------------------
+
+static uint16_t
+isqrt(uint32_t value) {
+	uint32_t ret = 0;
+	for(uint32_t bit = 1UL << 30; bit != 0; bit >>= 2) {
+		if (value >= ret + bit) {
+			value -= ret + bit;
+			ret = (ret >> 1) + bit;
+		}
+		else
+			ret >>= 1;
+	}
+
+	return ret;
+}
+
+
+// --- Measures ---------------------------------------------------------------
+
+struct measure {
+	const char* name;
+	uint16_t (*read)(uint8_t channel);
+	uint8_t extra_bits;
+	uint32_t mean;   // In hundredths of the output's LSB
+	uint16_t sd;     // Standard deviation, idem
+	uint16_t cycles; // Per output sample
+};
+
+
+// OUTPUT_COUNT outputs, the cycles of each conversion and decimation added
+// up. Timer1 stops in the ADC noise reduction sleep mode, as the CPU, thus
+// only the cycles the CPU is awake are counted.
+static void
+measure(struct measure* m, uint16_t overhead) {
+	struct adc_decimator decimator;
+	adc_decimator_init(&decimator, m->extra_bits);
+
+	uint32_t cycles = 0;
+	for(uint8_t i = 0; i < OUTPUT_COUNT; ) {
+		uint16_t start = cycles_now();
+		i += adc_decimator_push(&decimator, m->read(BENCH_CHANNEL), &outputs[i]);
+		cycles += (uint16_t)(cycles_now() - start - overhead);
+	}
+	m->cycles = cycles / OUTPUT_COUNT;
+
+	uint32_t sum = 0;
+	for(uint8_t i = 0; i < OUTPUT_COUNT; ++i)
+		sum += outputs[i];
+	uint32_t mean = sum * 100 / OUTPUT_COUNT;
+
+	uint32_t variance = 0;
+	for(uint8_t i = 0; i < OUTPUT_COUNT; ++i) {
+		int32_t delta = (int32_t)outputs[i] * 100 - (int32_t)mean;
+		variance += (uint32_t)(delta * delta) / OUTPUT_COUNT;
+	}
+
+	m->mean = mean;
+	m->sd = isqrt(variance);
+}
+
+
+int
+main(void) {
+	struct measure measures[] = {
+		{ "busy",  adc_read,       0 },
+		{ "quiet", adc_read_quiet, 0 },
+		{ "busy",  adc_read,       2 },
+		{ "quiet", adc_read_quiet, 1 },
+		{ "quiet", adc_read_quiet, 2 },
+		{ "quiet", adc_read_quiet, ADC_MAX_EXTRA_BITS }
+	};
+	uint8_t measure_count = sizeof(measures) / sizeof(measures[0]);
+
+	uart_init();
+	adc_init();
+	cycles_init();
+
+	// The ADC interrupt wakes the CPU up in the quiet mode, the UART stays
+	// silent until the report
+	sei();
+	uint16_t overhead = cycles_overhead();
+
+	// Let the input settle
+	for(uint8_t i = 0; i < 8; ++i)
+		adc_read(BENCH_CHANNEL);
+
+	for(uint8_t i = 0; i < measure_count; ++i)
+		measure(&measures[i], overhead);
+
+	// Report
+	fprintf(&uart_output, "--- ADC channel %u, %u outputs ---\r\n", BENCH_CHANNEL, OUTPUT_COUNT);
+	for(uint8_t i = 0; i < measure_count; ++i) {
+		struct measure* m = &measures[i];
+		fprintf(&uart_output, "%-6s %2u bits mean %4lu.%02u sd %2u.%02u LSB %5u cycles\r\n",
+			m->name, 10 + m->extra_bits,
+			m->mean / 100, (uint16_t)(m->mean % 100),
+			m->sd / 100, m->sd % 100,
+			m->cycles);
+	}
+
+	// Wait, do nothing loop
+	while(1)
+		sleep_mode();
+}
@@ -0,0 +1,119 @@
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+#include <stdio.h>
+
+#include "band.h"
+#include "framebuffer.h"
+#include "ssd1306.h"
+#include "uart.h"
+
+
+// Needs a SSD1306 screen, on the bus picked by SSD1306_TRANSPORT
+#define BENCH_COUNT 8
+
+
+// --- Test frame -------------------------------------------------------------
+
+// Diagonal stripes, every byte of the screen is computed
+static void
+draw_stripes(const struct band* band, void* context) {
+	uint8_t shift = *(const uint8_t*)context;
+	for(uint8_t i = 0; i < band->page_count; ++i) {
+		uint8_t y = 8 * (band->first_page + i);
+		for(uint8_t x = 0; x < SSD1306_WIDTH; ++x) {
+			uint8_t phase = (x + y + shift) % 16;
+			band->pages[i][x] = (phase < 8) ? (uint8_t)(0xff << phase) : (uint8_t)~(0xff << (phase - 8));
+		}
+	}
+}
+
+
+static uint8_t shift;
+
+
+// Drawing only, the framebuffer as a single band
+static void
+frame_draw_only() {
+	struct band band = { 0, SSD1306_PAGE_COUNT, framebuffer };
+	draw_stripes(&band, &shift);
+	shift += 1;
+}
+
+
+// Draw the whole frame, then send it
+static void
+frame_framebuffer() {
+	frame_draw_only();
+	for(uint8_t page = 0; page < SSD1306_PAGE_COUNT; ++page)
+		framebuffer_mark(page, 0, SSD1306_WIDTH - 1);
+	framebuffer_flush();
+}
+
+
+// Draw a band while the previous one is sent
+static void
+frame_band() {
+	band_render(draw_stripes, &shift);
+	shift += 1;
+}
+
+
+// --- Measures ---------------------------------------------------------------
+
+// Timer1 with a 64 prescaler, 4 usec per tick, wraps after 262 msec
+static inline void
+timer_init() {
+	TCCR1A = 0;
+	TCCR1B = _BV(CS11) | _BV(CS10);
+}
+
+
+struct measure {
+	const char* name;
+	uint16_t ram;  // Bytes of drawing buffers
+	uint32_t usec; // Per frame
+};
+
+
+static uint32_t
+measure(void (*operation)(void)) {
+	uint32_t ticks = 0;
+	for(uint8_t i = BENCH_COUNT; i != 0; --i) {
+		uint16_t start = TCNT1;
+		operation();
+		ticks += (uint16_t)(TCNT1 - start);
+	}
+
+	return 4 * ticks / BENCH_COUNT;
+}
+
+
+int
+main(void) {
+	struct measure measures[3];
+	struct measure* m = measures;
+
+	uart_init();
+	timer_init();
+	sei();
+
+	if (!ssd1306_init()) {
+		fputs("ssd1306 init failure\r\n", &uart_output);
+		goto waiting_loop;
+	}
+
+	*m++ = (struct measure){ "draw only", sizeof(framebuffer), measure(frame_draw_only) };
+	*m++ = (struct measure){ "framebuffer", sizeof(framebuffer), measure(frame_framebuffer) };
+	*m++ = (struct measure){ "band", 2 * BAND_SIZE, measure(frame_band) };
+
+	// Report
+	fprintf(&uart_output, "--- %ux%u frame ---\r\n", SSD1306_WIDTH, SSD1306_HEIGHT);
+	for(struct measure* it = measures; it != m; ++it)
+		fprintf(&uart_output, "%-12s %5u bytes %7lu usec\r\n", it->name, it->ram, it->usec);
+
+	// Wait, do nothing loop
+	waiting_loop:
+	while(1)
+		sleep_mode();
+}
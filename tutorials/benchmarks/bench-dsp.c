@@ -0,0 +1,107 @@
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+#include <stdio.h>
+
+#include "cycles.h"
+#include "dsp.h"
+#include "uart.h"
+
+
+#define BLOCK_SIZE 32
+
+static int16_t samples[BLOCK_SIZE];
+
+// Low-pass, 10 Hz at 1000 Hz, from biquad-to-code.py lowpass 10 1000
+static struct dsp_biquad lowpass = {
+	15, 31, 15, -31313, 14991
+};
+
+
+// A ramp with some noise, ADC-like values
+static void
+fill_samples() {
+	for(uint8_t i = 0; i < BLOCK_SIZE; ++i)
+		samples[i] = 400 + 8 * i + ((i * 37) & 15);
+}
+
+
+// --- Measures ---------------------------------------------------------------
+
+struct measure {
+	const char* name;
+	uint16_t cycles; // For the whole block
+};
+
+
+int
+main(void) {
+	struct measure measures[8];
+	struct measure* m = measures;
+
+	uart_init();
+	cycles_init();
+
+	cli();
+	uint16_t overhead = cycles_overhead();
+	uint16_t start;
+
+	struct dsp_iir1 iir1;
+	dsp_iir1_init(&iir1, 20, 400);
+	fill_samples();
+	start = cycles_now();
+	dsp_iir1(&iir1, samples, BLOCK_SIZE);
+	*m++ = (struct measure){ "iir1", cycles_now() - start - overhead };
+
+	dsp_biquad_reset(&lowpass);
+	fill_samples();
+	start = cycles_now();
+	dsp_biquad(&lowpass, samples, BLOCK_SIZE);
+	*m++ = (struct measure){ "biquad", cycles_now() - start - overhead };
+
+	int16_t history[16];
+	struct dsp_average average;
+	dsp_average_init(&average, history, 4, 400);
+	fill_samples();
+	start = cycles_now();
+	dsp_average(&average, samples, BLOCK_SIZE);
+	*m++ = (struct measure){ "average 16", cycles_now() - start - overhead };
+
+	struct dsp_cic cic;
+	dsp_cic_init(&cic, 3);
+	fill_samples();
+	start = cycles_now();
+	dsp_cic(&cic, samples, BLOCK_SIZE, samples);
+	*m++ = (struct measure){ "cic 8", cycles_now() - start - overhead };
+
+	struct dsp_median median;
+	dsp_median_init(&median, 3, 400);
+	fill_samples();
+	start = cycles_now();
+	dsp_median(&median, samples, BLOCK_SIZE);
+	*m++ = (struct measure){ "median 3", cycles_now() - start - overhead };
+
+	dsp_median_init(&median, DSP_MEDIAN_MAX_SIZE, 400);
+	fill_samples();
+	start = cycles_now();
+	dsp_median(&median, samples, BLOCK_SIZE);
+	*m++ = (struct measure){ "median 9", cycles_now() - start - overhead };
+
+	struct dsp_schmitt schmitt = { 500, 520, 0 };
+	fill_samples();
+	start = cycles_now();
+	dsp_schmitt(&schmitt, samples, BLOCK_SIZE);
+	*m++ = (struct measure){ "schmitt", cycles_now() - start - overhead };
+
+	// Report, in cycles per sample
+	sei();
+	fprintf(&uart_output, "--- blocks of %u samples, cycles per sample ---\r\n", BLOCK_SIZE);
+	for(struct measure* it = measures; it != m; ++it) {
+		uint16_t tenths = (uint32_t)it->cycles * 10 / BLOCK_SIZE;
+		fprintf(&uart_output, "%-12s %4u.%u\r\n", it->name, tenths / 10, tenths % 10);
+	}
+
+	// Wait, do nothing loop
+	while(1)
+		sleep_mode();
+}
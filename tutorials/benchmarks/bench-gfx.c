@@ -0,0 +1,110 @@
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+#include <stdio.h>
+
+#include "cycles.h"
+#include "gfx.h"
+#include "uart.h"
+
+
+// Drawing in RAM only, no screen needed
+static uint8_t pages[SSD1306_PAGE_COUNT][SSD1306_WIDTH];
+static const struct band screen = { 0, SSD1306_PAGE_COUNT, pages };
+
+// 16x16 ball
+static const __flash uint8_t ball[2 * 16] = {
+	0xe0, 0xf8, 0xfc, 0xfe, 0xfe, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe, 0xfe, 0xfc, 0xf8, 0xe0,
+	0x07, 0x1f, 0x3f, 0x7f, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f, 0x7f, 0x3f, 0x1f, 0x07
+};
+
+
+// --- Pixel by pixel, as framebuffer_set_pixel does ---------------------------
+
+static void
+legacy_fill_rect(uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
+	for(uint8_t j = y; j < y + height; ++j)
+		for(uint8_t i = x; i < x + width; ++i)
+			if ((i < SSD1306_WIDTH) && (j < SSD1306_HEIGHT))
+				pages[j / 8][i] |= _BV(j % 8);
+}
+
+
+// --- Measures ---------------------------------------------------------------
+
+struct measure {
+	const char* name;
+	uint16_t cycles;
+};
+
+
+int
+main(void) {
+	struct measure measures[12];
+	struct measure* m = measures;
+
+	uart_init();
+	cycles_init();
+
+	cli();
+	uint16_t overhead = cycles_overhead();
+	uint16_t start;
+
+	start = cycles_now();
+	legacy_fill_rect(10, 3, 32, 24);
+	*m++ = (struct measure){ "pixels 32x24", cycles_now() - start - overhead };
+
+	start = cycles_now();
+	gfx_fill_rect(&screen, 10, 3, 32, 24, GFX_SET);
+	*m++ = (struct measure){ "fill 32x24", cycles_now() - start - overhead };
+
+	start = cycles_now();
+	gfx_hline(&screen, 0, 5, SSD1306_WIDTH, GFX_INVERT);
+	*m++ = (struct measure){ "hline full", cycles_now() - start - overhead };
+
+	start = cycles_now();
+	gfx_vline(&screen, 7, 0, SSD1306_HEIGHT, GFX_INVERT);
+	*m++ = (struct measure){ "vline full", cycles_now() - start - overhead };
+
+	start = cycles_now();
+	gfx_rect(&screen, 10, 3, 32, 24, GFX_INVERT);
+	*m++ = (struct measure){ "rect 32x24", cycles_now() - start - overhead };
+
+	start = cycles_now();
+	gfx_line(&screen, 0, 0, SSD1306_WIDTH - 1, SSD1306_HEIGHT - 1, GFX_INVERT);
+	*m++ = (struct measure){ "line flat", cycles_now() - start - overhead };
+
+	start = cycles_now();
+	gfx_line(&screen, 0, 0, 7, SSD1306_HEIGHT - 1, GFX_INVERT);
+	*m++ = (struct measure){ "line steep", cycles_now() - start - overhead };
+
+	start = cycles_now();
+	gfx_circle(&screen, 64, SSD1306_HEIGHT / 2, 15, GFX_INVERT);
+	*m++ = (struct measure){ "circle r15", cycles_now() - start - overhead };
+
+	start = cycles_now();
+	gfx_fill_circle(&screen, 64, SSD1306_HEIGHT / 2, 15, GFX_INVERT);
+	*m++ = (struct measure){ "disc r15", cycles_now() - start - overhead };
+
+	start = cycles_now();
+	gfx_blit(&screen, 20, 8, ball, 16, 16, GFX_XOR);
+	*m++ = (struct measure){ "blit aligned", cycles_now() - start - overhead };
+
+	start = cycles_now();
+	gfx_blit(&screen, 20, 11, ball, 16, 16, GFX_XOR);
+	*m++ = (struct measure){ "blit shifted", cycles_now() - start - overhead };
+
+	start = cycles_now();
+	gfx_blit(&screen, 20, 11, ball, 16, 16, GFX_AND);
+	*m++ = (struct measure){ "blit and", cycles_now() - start - overhead };
+
+	// Report
+	sei();
+	fprintf(&uart_output, "--- %ux%u, cycles ---\r\n", SSD1306_WIDTH, SSD1306_HEIGHT);
+	for(struct measure* it = measures; it != m; ++it)
+		fprintf(&uart_output, "%-14s %6u\r\n", it->name, it->cycles);
+
+	// Wait, do nothing loop
+	while(1)
+		sleep_mode();
+}
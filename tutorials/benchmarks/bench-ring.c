@@ -0,0 +1,123 @@
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+#include <stdio.h>
+
+#include "cycles.h"
+#include "ring.h"
+#include "uart.h"
+
+
+#define BENCH_SIZE 64
+#define BENCH_COUNT (BENCH_SIZE - 1)
+
+static volatile char sink;
+static char block[BENCH_COUNT];
+
+
+// --- Ring buffer as it was written in the tutorials, before ring.h ----------
+
+static volatile uint8_t legacy_start;
+static volatile uint8_t legacy_end;
+static volatile char legacy_buffer[BENCH_SIZE];
+
+
+static void
+legacy_push(char c) {
+	uint8_t legacy_next_end = (legacy_end + 1) % BENCH_SIZE;
+	if (legacy_next_end == legacy_start)
+		return;
+
+	cli();
+	legacy_buffer[legacy_end] = c;
+	legacy_end = legacy_next_end;
+	sei();
+}
+
+
+static char
+legacy_pop() {
+	cli();
+	char ret = legacy_buffer[legacy_start];
+	legacy_start = (legacy_start + 1) % BENCH_SIZE;
+	sei();
+
+	return ret;
+}
+
+
+// --- ring.h ring buffer -----------------------------------------------------
+
+RING_DEFINE(bench_ring, char, BENCH_SIZE)
+static struct bench_ring ring;
+
+
+// --- Measures ---------------------------------------------------------------
+
+struct measure {
+	const char* name;
+	uint16_t cycles;
+};
+
+
+int
+main(void) {
+	struct measure measures[6];
+	struct measure* m = measures;
+
+	uart_init();
+	cycles_init();
+
+	// Interrupts are kept disabled while measuring. legacy_push and
+	// legacy_pop do enable them, but nothing is sent nor received meanwhile.
+	cli();
+	uint16_t overhead = cycles_overhead();
+	uint16_t start;
+
+	start = cycles_now();
+	for(uint8_t i = BENCH_COUNT; i != 0; --i)
+		legacy_push(i);
+	*m++ = (struct measure){ "legacy push", cycles_now() - start - overhead };
+	cli();
+
+	start = cycles_now();
+	for(uint8_t i = BENCH_COUNT; i != 0; --i)
+		sink = legacy_pop();
+	*m++ = (struct measure){ "legacy pop", cycles_now() - start - overhead };
+	cli();
+
+	bench_ring_init(&ring);
+	start = cycles_now();
+	for(uint8_t i = BENCH_COUNT; i != 0; --i)
+		bench_ring_push(&ring, i);
+	*m++ = (struct measure){ "ring push", cycles_now() - start - overhead };
+
+	start = cycles_now();
+	for(uint8_t i = BENCH_COUNT; i != 0; --i) {
+		char c;
+		bench_ring_pop(&ring, &c);
+		sink = c;
+	}
+	*m++ = (struct measure){ "ring pop", cycles_now() - start - overhead };
+
+	// Indices are now at 63, so that the bulk copies wrap around
+	start = cycles_now();
+	bench_ring_push_n(&ring, block, BENCH_COUNT);
+	*m++ = (struct measure){ "ring push_n", cycles_now() - start - overhead };
+
+	start = cycles_now();
+	bench_ring_pop_n(&ring, block, BENCH_COUNT);
+	*m++ = (struct measure){ "ring pop_n", cycles_now() - start - overhead };
+
+	// Report, in cycles per byte
+	sei();
+	fprintf(&uart_output, "--- %u bytes, cycles per byte ---\r\n", BENCH_COUNT);
+	for(struct measure* it = measures; it != m; ++it) {
+		uint16_t hundredths = (uint32_t)it->cycles * 100 / BENCH_COUNT;
+		fprintf(&uart_output, "%-12s %3u.%02u\r\n", it->name, hundredths / 100, hundredths % 100);
+	}
+
+	// Wait, do nothing loop
+	while(1)
+		sleep_mode();
+}
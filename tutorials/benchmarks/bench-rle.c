@@ -0,0 +1,71 @@
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+#include <stdio.h>
+
+#include "cycles.h"
+#include "rle.h"
+#include "ssd1306.h"
+#include "uart.h"
+
+
+// The bitmap of the ssd1306 example, as it is and run-length encoded
+#include "bitmap-raw.c"
+#include "bitmap-rle.c"
+
+static uint8_t buffer[SSD1306_BUFFER_SIZE];
+
+
+// --- Measures ---------------------------------------------------------------
+
+struct measure {
+	const char* name;
+	uint16_t size;   // Bytes of flash
+	uint16_t cycles; // For the whole bitmap
+};
+
+
+int
+main(void) {
+	struct measure measures[3];
+	struct measure* m = measures;
+
+	uart_init();
+	cycles_init();
+
+	cli();
+	uint16_t overhead = cycles_overhead();
+	uint16_t start;
+
+	// Copy from the flash memory, as framebuffer_load does
+	start = cycles_now();
+	for(uint16_t i = 0; i < SSD1306_BUFFER_SIZE; ++i)
+		buffer[i] = bitmap_raw[i];
+	*m++ = (struct measure){ "raw", sizeof(bitmap_raw), cycles_now() - start - overhead };
+
+	// Decoded at once
+	struct rle_decoder decoder;
+	start = cycles_now();
+	rle_init(&decoder, bitmap_rle);
+	rle_decode(&decoder, buffer, SSD1306_BUFFER_SIZE);
+	*m++ = (struct measure){ "rle", sizeof(bitmap_rle), cycles_now() - start - overhead };
+
+	// Decoded a chunk at a time, as rle_upload_bitmap does
+	start = cycles_now();
+	rle_init(&decoder, bitmap_rle);
+	for(uint16_t i = 0; i < SSD1306_BUFFER_SIZE; i += RLE_CHUNK_SIZE)
+		rle_decode(&decoder, buffer + i, RLE_CHUNK_SIZE);
+	*m++ = (struct measure){ "rle chunks", sizeof(bitmap_rle), cycles_now() - start - overhead };
+
+	// Report, in cycles per byte
+	sei();
+	fprintf(&uart_output, "--- %u bytes bitmap, cycles per byte ---\r\n", SSD1306_BUFFER_SIZE);
+	for(struct measure* it = measures; it != m; ++it) {
+		uint16_t hundredths = (uint32_t)it->cycles * 100 / SSD1306_BUFFER_SIZE;
+		fprintf(&uart_output, "%-12s %4u bytes %3u.%02u\r\n", it->name, it->size, hundredths / 100, hundredths % 100);
+	}
+
+	// Wait, do nothing loop
+	while(1)
+		sleep_mode();
+}
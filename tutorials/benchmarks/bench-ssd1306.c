@@ -0,0 +1,135 @@
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+#include <stdio.h>
+
+#include "ssd1306.h"
+#include "twi.h"
+#include "uart.h"
+
+
+// Needs a SSD1306 screen on the I2C bus
+#define F_SCL 100000UL
+
+#define BENCH_COUNT 16
+
+
+// --- Commands as the helpers sent them, before the command queue -------------
+
+static uint8_t
+legacy_send_command(uint8_t command) {
+	struct twi_transaction transaction = {
+		.address = SSD1306_ADDRESS,
+		.header_length = 2,
+		.header = { SSD1306_COMMAND, command }
+	};
+
+	return twi_transfer(&transaction) == TWI_OK;
+}
+
+
+static uint8_t
+legacy_send_command_stream(const uint8_t* commands, uint8_t command_count) {
+	struct twi_transaction transaction = {
+		.address = SSD1306_ADDRESS,
+		.header_length = 1,
+		.header = { SSD1306_COMMAND_STREAM },
+		.write_buffer.ram = commands,
+		.write_length = command_count
+	};
+
+	return twi_transfer(&transaction) == TWI_OK;
+}
+
+
+static const uint8_t scroll_commands[7] = {
+	SSD1306_RIGHT_HORIZONTAL_SCROLL, 0x00, 0, 0x00, 3, 0x00, 0xff
+};
+
+
+// Inverse display, then restart the scrolling, one transaction per helper
+static void
+legacy_mode_change() {
+	legacy_send_command(SSD1306_DIS_INVERSE);
+	legacy_send_command(SSD1306_DEACT_SCROLL);
+	legacy_send_command_stream(scroll_commands, sizeof(scroll_commands));
+	legacy_send_command(SSD1306_ACTIVE_SCROLL);
+}
+
+
+// Same commands, as a single command stream
+static void
+batch_mode_change() {
+	ssd1306_begin_batch();
+	ssd1306_set_inverse_display_mode();
+	ssd1306_deactivate_scroll();
+	ssd1306_setup_horizontal_scroll(0, 3, 1, SSD1306_SCROLL_5_FRAMES);
+	ssd1306_activate_scroll();
+	ssd1306_end_batch();
+}
+
+
+// --- Measures ---------------------------------------------------------------
+
+// Timer1 with a 8 prescaler, 2 ticks per usec, wraps after 32 msec
+static inline void
+timer_init() {
+	TCCR1A = 0;
+	TCCR1B = _BV(CS11);
+}
+
+
+struct measure {
+	const char* name;
+	uint16_t bytes; // Bytes on the bus, slave address included
+	uint16_t usec;
+};
+
+
+static uint16_t
+measure(void (*operation)(void)) {
+	uint32_t ticks = 0;
+	for(uint8_t i = BENCH_COUNT; i != 0; --i) {
+		uint16_t start = TCNT1;
+		operation();
+		ticks += (uint16_t)(TCNT1 - start);
+	}
+
+	return ticks / (2 * BENCH_COUNT);
+}
+
+
+int
+main(void) {
+	struct measure measures[2];
+	struct measure* m = measures;
+
+	uart_init();
+	twi_init(TWI_BITRATE(F_SCL));
+	timer_init();
+	sei();
+
+	if (!ssd1306_init()) {
+		fputs("ssd1306 init failure\r\n", &uart_output);
+		goto waiting_loop;
+	}
+
+	// 3 transactions of 3 bytes, 1 of 9 bytes
+	*m++ = (struct measure){ "one by one", 3 * 3 + 9, measure(legacy_mode_change) };
+
+	// 1 transaction: address, control byte, 10 commands
+	*m++ = (struct measure){ "batch", 12, measure(batch_mode_change) };
+
+	ssd1306_deactivate_scroll();
+	ssd1306_set_normal_display_mode();
+
+	// Report
+	fprintf(&uart_output, "--- mode change, %lu Hz ---\r\n", F_SCL);
+	for(struct measure* it = measures; it != m; ++it)
+		fprintf(&uart_output, "%-12s %3u bytes %6u usec\r\n", it->name, it->bytes, it->usec);
+
+	// Wait, do nothing loop
+	waiting_loop:
+	while(1)
+		sleep_mode();
+}
@@ -0,0 +1,108 @@
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+#include <stdio.h>
+
+#include "cycles.h"
+#include "uart.h"
+
+
+// The handlers are called directly, with interrupts disabled. They return
+// with reti, which enables interrupts again, hence the cli after each call.
+void USART_RX_vect(void);
+void USART_UDRE_vect(void);
+
+// Less than the reception buffer size, so that no byte is dropped
+#define BENCH_COUNT 16
+
+static char block[BENCH_COUNT];
+
+
+// Reception hook storing every byte, to measure the full handler
+static uint8_t
+store_hook(char c) {
+	return 0;
+}
+
+
+// --- Measures ---------------------------------------------------------------
+
+struct measure {
+	const char* name;
+	uint16_t cycles;
+};
+
+
+static uint16_t
+measure_rx(uint16_t overhead) {
+	uint16_t cycles = 0;
+	for(uint8_t i = BENCH_COUNT; i != 0; --i) {
+		uint16_t start = cycles_now();
+		USART_RX_vect();
+		cycles += cycles_now() - start - overhead;
+		cli();
+	}
+
+	// Empty the reception buffer
+	uart_try_read(block, BENCH_COUNT);
+	return cycles;
+}
+
+
+static uint16_t
+measure_udre(uint16_t overhead) {
+	uint16_t cycles = 0;
+	for(uint8_t i = BENCH_COUNT; i != 0; --i) {
+		// One byte to send, and room in UDR0
+		uart_try_write(".", 1);
+		loop_until_bit_is_set(UCSR0A, UDRE0);
+
+		uint16_t start = cycles_now();
+		USART_UDRE_vect();
+		cycles += cycles_now() - start - overhead;
+		cli();
+	}
+
+	return cycles;
+}
+
+
+int
+main(void) {
+	struct measure measures[3];
+	struct measure* m = measures;
+
+	uart_init();
+	cycles_init();
+
+	// Nothing is received meanwhile, the reception handler reads whatever
+	// is in UDR0
+	cli();
+	uint16_t overhead = cycles_overhead();
+
+	*m++ = (struct measure){ "rx", measure_rx(overhead) };
+
+	uart_set_rx_hook(store_hook);
+	cli();
+	*m++ = (struct measure){ "rx, hook", measure_rx(overhead) };
+	uart_set_rx_hook(0);
+	cli();
+
+	*m++ = (struct measure){ "udre", measure_udre(overhead) };
+
+	// Report, in cycles per call, call and return included
+	sei();
+	#ifdef UART_FAST_ISR
+	fputs("--- assembly handlers, cycles per call ---\r\n", &uart_output);
+	#else
+	fputs("--- C handlers, cycles per call ---\r\n", &uart_output);
+	#endif
+	for(struct measure* it = measures; it != m; ++it) {
+		uint16_t hundredths = (uint32_t)it->cycles * 100 / BENCH_COUNT;
+		fprintf(&uart_output, "%-12s %3u.%02u\r\n", it->name, hundredths / 100, hundredths % 100);
+	}
+
+	// Wait, do nothing loop
+	while(1)
+		sleep_mode();
+}
@@ -0,0 +1,253 @@
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+#include <string.h>
+
+#include "adc.h"
+
+
+// A conversion of a scan, for a channel, or dropped to let the input settle
+struct adc_slot {
+	uint8_t admux;
+	struct adc_channel* channel; // 0 if dropped
+};
+
+static struct adc_slot adc_slots[2 * ADC_SCAN_MAX_CHANNELS];
+static uint8_t adc_slot_count;
+static uint8_t adc_slot_index; // Slot being converted
+
+// The channel of adc_start
+static struct adc_channel adc_single;
+
+// Written by the interrupt handler, read with interrupts disabled
+static struct adc_stats adc_stats;
+
+// Set by the interrupt handler at the end of a single conversion
+static volatile uint8_t adc_done;
+
+// Highest rates for the ADC clock, see adc_set_clock
+static uint16_t adc_max_rate;
+static uint16_t adc_max_scan_rate;
+
+
+// The trigger is the rising edge of the compare match flag, cleared by
+// entering this handler right after it, for the next one. Cleared by the ADC
+// handler instead, after the conversion, the flag would still be set at the
+// next compare match with the faster clocks, and triggers would be missed.
+EMPTY_INTERRUPT(TIMER1_COMPB_vect);
+
+
+ISR(ADC_vect) {
+	// Single conversion, from adc_read_quiet
+	if (!(ADCSRA & _BV(ADATE))) {
+		adc_done = 1;
+		return;
+	}
+
+	uint16_t value = ADCW;
+
+	// Input of the next conversion, which starts at the next trigger
+	struct adc_channel* channel = adc_slots[adc_slot_index].channel;
+	if (++adc_slot_index == adc_slot_count)
+		adc_slot_index = 0;
+	ADMUX = adc_slots[adc_slot_index].admux;
+
+	if (!channel)
+		return;
+
+	adc_stats.samples += 1;
+	if (!adc_ring_push(&channel->ring, value))
+		adc_stats.overruns += 1;
+}
+
+
+void
+adc_init(void) {
+	// Voltage reference from AVcc
+	ADMUX = ADC_REF_AVCC;
+
+	// ADC clock to 16 MHz / 128 = 125 kHz, ADC on
+	ADCSRA = _BV(ADEN);
+	adc_set_clock(ADC_CLOCK_DIV_128);
+}
+
+
+void
+adc_set_clock(uint8_t clock) {
+	ADCSRA = (ADCSRA & ~ADC_CLOCK_MASK) | (clock & ADC_CLOCK_MASK);
+
+	// Scans at the faster clocks need time to switch the input
+	switch(clock & ADC_CLOCK_MASK) {
+		case ADC_CLOCK_DIV_16:
+			adc_max_rate = ADC_MAX_RATE_DIV_16;
+			adc_max_scan_rate = ADC_MAX_RATE_DIV_16 / 2;
+			break;
+		case ADC_CLOCK_DIV_32:
+			adc_max_rate = ADC_MAX_RATE_DIV_32;
+			adc_max_scan_rate = ADC_MAX_RATE_DIV_32 / 2;
+			break;
+		default:
+			adc_max_rate = ADC_MAX_RATE;
+			adc_max_scan_rate = ADC_MAX_RATE;
+	}
+}
+
+
+uint16_t
+adc_read(uint8_t channel) {
+	ADMUX = (ADMUX & ADC_REF_MASK) | (channel & 0x0f);
+
+	// ADSC goes back to 0 once the conversion is over
+	ADCSRA |= _BV(ADSC);
+	while(ADCSRA & _BV(ADSC));
+
+	return ADCW;
+}
+
+
+uint16_t
+adc_read_quiet(uint8_t channel) {
+	ADMUX = (ADMUX & ADC_REF_MASK) | (channel & 0x0f);
+
+	// Entering the ADC noise reduction mode starts the conversion, and the
+	// interrupt wakes the CPU up. If another interrupt comes first, going
+	// back to sleep does not start another one, the ADC is busy.
+	// A result left by adc_read or adc_stop must not wake the CPU up: clear
+	// its flag along with enabling the interrupt.
+	set_sleep_mode(SLEEP_MODE_ADC);
+	ADCSRA |= _BV(ADIE) | _BV(ADIF);
+
+	cli();
+	adc_done = 0;
+	while(!adc_done) {
+		sleep_enable();
+		sei();
+		sleep_cpu();
+		sleep_disable();
+		cli();
+	}
+	sei();
+
+	ADCSRA &= ~_BV(ADIE);
+	set_sleep_mode(SLEEP_MODE_IDLE);
+
+	return ADCW;
+}
+
+
+uint16_t
+adc_read_oversampled(uint8_t channel, uint8_t extra_bits) {
+	struct adc_decimator decimator;
+	adc_decimator_init(&decimator, extra_bits);
+
+	uint16_t ret;
+	while(!adc_decimator_push(&decimator, adc_read_quiet(channel), &ret));
+
+	return ret;
+}
+
+
+uint8_t
+adc_start(uint8_t channel, uint16_t rate) {
+	adc_single.admux = ADC_REF_AVCC | (channel & (ADC_LEFT_ADJUST | 0x0f));
+	adc_single.settle = 0;
+	return adc_scan_start(&adc_single, 1, rate) != 0;
+}
+
+
+uint16_t
+adc_scan_start(struct adc_channel* channels, uint8_t count, uint16_t rate) {
+	uint16_t max_rate = (count == 1) ? adc_max_rate : adc_max_scan_rate;
+	if ((count == 0) || (count > ADC_SCAN_MAX_CHANNELS) || (rate < ADC_MIN_RATE) || (rate > max_rate))
+		return 0;
+
+	adc_stop();
+
+	// One slot per channel, plus one before it if its input has to settle
+	adc_slot_count = 0;
+	for(uint8_t i = 0; i < count; ++i) {
+		struct adc_channel* channel = &channels[i];
+		adc_ring_init(&channel->ring);
+
+		uint8_t previous = channels[(i == 0) ? count - 1 : i - 1].admux;
+		if ((count > 1) && (channel->settle || ((previous ^ channel->admux) & ADC_REF_MASK)))
+			adc_slots[adc_slot_count++] = (struct adc_slot){ channel->admux, 0 };
+		adc_slots[adc_slot_count++] = (struct adc_slot){ channel->admux, channel };
+	}
+	adc_slot_index = 0;
+	ADMUX = adc_slots[0].admux;
+
+	// Timer1 in CTC mode, prescaler 8, compare match B at the top
+	uint16_t top = F_CPU / 8 / rate - 1;
+	TCCR1A = 0;
+	TCCR1B = _BV(WGM12);
+	OCR1A = top;
+	OCR1B = top;
+	TCNT1 = 0;
+	TIFR1 = _BV(OCF1B);
+	TIMSK1 |= _BV(OCIE1B);
+
+	// Auto-trigger on Timer1 compare match B, interrupt for each result
+	ADCSRB = _BV(ADTS2) | _BV(ADTS0);
+	ADCSRA |= _BV(ADATE) | _BV(ADIE) | _BV(ADIF);
+
+	// Go
+	TCCR1B |= _BV(CS11);
+
+	// Job done
+	return rate / adc_slot_count;
+}
+
+
+void
+adc_stop(void) {
+	TCCR1B = 0;
+	TIMSK1 &= ~_BV(OCIE1B);
+	ADCSRA &= ~(_BV(ADATE) | _BV(ADIE));
+
+	// A conversion might be on the way
+	while(ADCSRA & _BV(ADSC));
+}
+
+
+void
+adc_read_channel(struct adc_channel* channel, uint16_t* samples, uint8_t count) {
+	// Sleeps until the block is complete. Interrupts are enabled right
+	// before sleep_cpu, so that the wake-up interrupt cannot be missed.
+	cli();
+	while(adc_ring_count(&channel->ring) < count) {
+		sleep_enable();
+		sei();
+		sleep_cpu();
+		sleep_disable();
+		cli();
+	}
+	sei();
+
+	adc_ring_pop_n(&channel->ring, samples, count);
+}
+
+
+void
+adc_read_block(uint16_t* samples, uint8_t count) {
+	adc_read_channel(&adc_single, samples, count);
+}
+
+
+uint8_t
+adc_decimate(struct adc_decimator* decimator, const uint16_t* samples, uint8_t count, uint16_t* out) {
+	uint8_t ret = 0;
+	for(uint8_t i = 0; i < count; ++i)
+		ret += adc_decimator_push(decimator, samples[i], out + ret);
+
+	return ret;
+}
+
+
+void
+adc_get_stats(struct adc_stats* stats) {
+	cli();
+	*stats = adc_stats;
+	memset(&adc_stats, 0, sizeof(adc_stats));
+	sei();
+}
@@ -0,0 +1,186 @@
+#ifndef ADC_H
+#define ADC_H
+
+#include <avr/io.h>
+#include <stdint.h>
+
+#include "ring.h"
+
+
+// --- Timer-triggered ADC acquisition ----------------------------------------
+//
+// Conversions are started by the hardware at a fixed rate, with auto-trigger
+// on Timer1 compare match B: no jitter from the software, and only an empty
+// interrupt handler between the conversions. The ADC_vect interrupt handler
+// pushes each result in the ring of its channel, the main loop takes them a
+// block at a time. A result that finds the ring full is dropped, and counted
+// as an overrun.
+//
+// A scan goes through a list of channels, one conversion per trigger, in
+// slots. The interrupt handler switches the input for the next conversion,
+// which only starts at the next trigger: each channel is sampled at exactly
+// the conversion rate divided by the number of slots. A channel switched to
+// with a different reference, or flagged to settle, gets an extra slot before
+// its own, whose result is dropped.
+//
+// Timer1 is taken over while the acquisition runs, thus it does not mix with
+// cycles.h. The ADC clock is 16 MHz / 128 = 125 kHz by default, a conversion
+// takes 13.5 ADC cycles when auto-triggered, 108 usec. adc_set_clock picks a
+// faster clock, 500 kHz or 1 MHz, for higher rates: the ADC gives its 10 bits
+// up to about 200 kHz only, beyond that the 8 highest bits are what is left.
+// With ADC_LEFT_ADJUST in the channel, the result is left adjusted: the high
+// byte of each sample is the 8 bits conversion.
+//
+// Oversampling gains resolution, if the input has at least 1 LSB of noise:
+// the sum of 4^n samples, shifted right by n, is a sample of 10 + n bits. The
+// decimator does that on a stream of samples, for instance 12 bits at 100 Hz
+// from an acquisition at 1600 Hz. For the lowest noise, adc_read_quiet
+// converts in the ADC noise reduction sleep mode, with the CPU and the I/O
+// clock stopped, thus without a timer to pace it.
+
+// Samples in the ring of each channel, a power of two, twice that in bytes
+#ifndef ADC_RING_SIZE
+#define ADC_RING_SIZE 32
+#endif
+
+#ifndef ADC_SCAN_MAX_CHANNELS
+#define ADC_SCAN_MAX_CHANNELS 8
+#endif
+
+// Conversions per second. Timer1 runs at 2 MHz, the highest rate leaves the
+// interrupt handler time to switch the input before the next trigger. With
+// the faster clocks, a conversion takes at most 14.5 ADC cycles from the
+// trigger, the highest rates leave the interrupt handler too little time for
+// that: scans are limited to half of them. A single channel needs no switch,
+// and the trigger flag is cleared by a handler of its own, right after the
+// trigger.
+#define ADC_MIN_RATE 31
+#define ADC_MAX_RATE 8000         // ADC_CLOCK_DIV_128
+#define ADC_MAX_RATE_DIV_32 32000
+#define ADC_MAX_RATE_DIV_16 64000
+
+// ADC clocks, as the ADPS bits of ADCSRA
+#define ADC_CLOCK_DIV_128 (_BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0)) // 125 kHz
+#define ADC_CLOCK_DIV_32  (_BV(ADPS2) | _BV(ADPS0))              // 500 kHz
+#define ADC_CLOCK_DIV_16  _BV(ADPS2)                             // 1 MHz
+#define ADC_CLOCK_MASK    (_BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0))
+
+// References, as the REFS bits of ADMUX
+#define ADC_REF_AREF 0x00
+#define ADC_REF_AVCC _BV(REFS0)
+#define ADC_REF_1V1  (_BV(REFS1) | _BV(REFS0))
+#define ADC_REF_MASK (_BV(REFS1) | _BV(REFS0))
+
+// Inputs besides ADC0 to ADC7
+#define ADC_TEMPERATURE 8  // Internal sensor, with ADC_REF_1V1 only
+#define ADC_BANDGAP     14 // 1.1 V, against AVcc it measures the supply
+#define ADC_GROUND      15
+
+// Left adjusted result, as the ADLAR bit of ADMUX, for the acquisition only
+#define ADC_LEFT_ADJUST _BV(ADLAR)
+
+
+RING_DEFINE(adc_ring, uint16_t, ADC_RING_SIZE)
+
+// A channel of a scan, and its samples
+struct adc_channel {
+	uint8_t admux;        // Reference, input and adjustment, ie. ADC_REF_AVCC | 3
+	uint8_t settle;       // 1 to drop the first conversion after a switch
+	struct adc_ring ring; // Emptied when the scan starts
+};
+
+
+// Up to 64 samples, whose sum fits in 16 bits: 13 bits at most
+#define ADC_MAX_EXTRA_BITS 3
+
+struct adc_decimator {
+	uint16_t sum;
+	uint8_t count;      // Samples left for the current output
+	uint8_t extra_bits;
+};
+
+
+// Acquisition counters, cleared by adc_get_stats
+struct adc_stats {
+	uint16_t samples;  // Conversions kept
+	uint16_t overruns; // Samples dropped, the ring was full
+};
+
+
+// Reference and clock setup, the ADC is switched on
+void
+adc_init(void);
+
+// One of the ADC_CLOCK_* values, ADC_CLOCK_DIV_128 after adc_init. Only when
+// the acquisition is stopped.
+void
+adc_set_clock(uint8_t clock);
+
+// A single conversion on a channel, waits for it. Only when the acquisition
+// is stopped.
+uint16_t
+adc_read(uint8_t channel);
+
+// As adc_read, in the ADC noise reduction sleep mode. Anything that needs the
+// I/O clock stops meanwhile, the UART should be done sending.
+uint16_t
+adc_read_quiet(uint8_t channel);
+
+// Sum of 4^extra_bits conversions with adc_read_quiet, on 10 + extra_bits
+// bits
+uint16_t
+adc_read_oversampled(uint8_t channel, uint8_t extra_bits);
+
+// Starts the acquisition of a channel, against AVcc, at rate samples per
+// second. The channel can be or-ed with ADC_LEFT_ADJUST. Returns 0 if the
+// rate is out of range for the ADC clock.
+uint8_t
+adc_start(uint8_t channel, uint16_t rate);
+
+// Starts a scan of count channels, rate conversions per second. Returns
+// the rate of each channel, 0 if the arguments are out of range.
+uint16_t
+adc_scan_start(struct adc_channel* channels, uint8_t count, uint16_t rate);
+
+void
+adc_stop(void);
+
+// Sleeps until count samples of a channel are there, then copies them. count
+// should not be larger than ADC_RING_SIZE.
+void
+adc_read_channel(struct adc_channel* channel, uint16_t* samples, uint8_t count);
+
+// As adc_read_channel, for the channel of adc_start
+void
+adc_read_block(uint16_t* samples, uint8_t count);
+
+static inline void
+adc_decimator_init(struct adc_decimator* decimator, uint8_t extra_bits) {
+	decimator->sum = 0;
+	decimator->count = 1 << (2 * extra_bits);
+	decimator->extra_bits = extra_bits;
+}
+
+// Adds a sample, returns 1 once 4^extra_bits samples were added, then *out
+// is their decimated sum
+static inline uint8_t
+adc_decimator_push(struct adc_decimator* decimator, uint16_t sample, uint16_t* out) {
+	decimator->sum += sample;
+	if (--decimator->count != 0)
+		return 0;
+
+	*out = decimator->sum >> decimator->extra_bits;
+	adc_decimator_init(decimator, decimator->extra_bits);
+	return 1;
+}
+
+// Decimates a block of samples, returns the number of outputs written
+uint8_t
+adc_decimate(struct adc_decimator* decimator, const uint16_t* samples, uint8_t count, uint16_t* out);
+
+// Copy the counters, then reset them
+void
+adc_get_stats(struct adc_stats* stats);
+
+
+#endif /* ADC_H */
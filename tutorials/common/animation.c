@@ -0,0 +1,76 @@
+#include <avr/io.h>
+#include <string.h>
+
+#include "animation.h"
+#include "framebuffer.h"
+#include "rle.h"
+#include "tick.h"
+
+
+// Applies a frame to the framebuffer, returns the start of the next frame
+static const __flash uint8_t*
+animation_apply(const __flash uint8_t* data) {
+	uint8_t span_count = *data++;
+
+	// Keyframe, the whole screen changes
+	if (span_count == ANIMATION_KEYFRAME) {
+		struct rle_decoder decoder;
+		rle_init(&decoder, data);
+		rle_decode(&decoder, &framebuffer[0][0], SSD1306_BUFFER_SIZE);
+		for(uint8_t page = 0; page < SSD1306_PAGE_COUNT; ++page)
+			framebuffer_mark(page, 0, SSD1306_WIDTH - 1);
+		return decoder.data;
+	}
+
+	// Delta frame, only the spans change
+	for( ; span_count != 0; --span_count) {
+		uint8_t page = *data++;
+		uint8_t first = *data++;
+		uint8_t length = *data++;
+
+		uint8_t* ptr = &framebuffer[page][first];
+		for(uint8_t i = 0; i < length; ++i)
+			ptr[i] ^= *data++;
+		framebuffer_mark(page, first, first + length - 1);
+	}
+
+	return data;
+}
+
+
+uint8_t
+animation_play(const struct animation* animation, uint8_t loop_count, struct animation_stats* stats) {
+	memset(stats, 0, sizeof(*stats));
+
+	uint16_t start = tick_now();
+	uint16_t frame = 0; // Frames since start, for the due times
+	for( ; loop_count != 0; --loop_count) {
+		const __flash uint8_t* data = animation->data;
+		for(uint16_t i = 0; i < animation->frame_count; ++i, ++frame) {
+			data = animation_apply(data);
+
+			// Computed from start, so that rounding errors do not add up
+			uint16_t due = start + (uint32_t)frame * 1000 / animation->fps;
+			uint16_t next_due = start + (uint32_t)(frame + 1) * 1000 / animation->fps;
+
+			// Too late for this one, its changes go with the next one
+			if (tick_reached(tick_now(), next_due)) {
+				stats->dropped += 1;
+				continue;
+			}
+
+			tick_sleep_until(due);
+			if (!framebuffer_flush())
+				return 0;
+			stats->shown += 1;
+		}
+	}
+
+	// The last frame might have been dropped
+	if (!framebuffer_flush())
+		return 0;
+	stats->msec = tick_now() - start;
+
+	// Job done
+	return 1;
+}
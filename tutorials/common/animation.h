@@ -0,0 +1,44 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <stdint.h>
+
+
+// --- Delta encoded animations -----------------------------------------------
+//
+// Frame sequences in flash, as animation-to-code.py writes them, played
+// through the framebuffer. Each frame starts with a byte
+//   0xff : keyframe, the whole screen follows, run-length encoded (rle.h)
+//   n    : n spans follow, each as page, first column, length, then length
+//          bytes XORed with the previous frame
+// The first frame is a keyframe, so that the animation can loop. Only the
+// spans of a delta frame are marked dirty, framebuffer_flush sends those.
+//
+// Frames are paced by the msec tick of tick.h, which should be running. A
+// frame that is not shown before the next one is due is dropped : it is
+// still applied to the framebuffer, but not sent.
+
+#define ANIMATION_KEYFRAME 0xff
+
+
+struct animation {
+	const __flash uint8_t* data;
+	uint16_t frame_count;
+	uint8_t fps;                 // Frames per second, at least 1
+};
+
+
+// Frames of animation_play, over loop_count loops
+struct animation_stats {
+	uint16_t shown;
+	uint16_t dropped;
+	uint16_t msec;   // Time taken, thus fps is shown * 1000 / msec
+};
+
+
+// Plays the animation loop_count times. Returns 0 on failure.
+uint8_t
+animation_play(const struct animation* animation, uint8_t loop_count, struct animation_stats* stats);
+
+
+#endif /* ANIMATION_H */
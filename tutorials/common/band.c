@@ -0,0 +1,56 @@
+#include <avr/io.h>
+#include <string.h>
+
+#include "band.h"
+#include "ssd1306.h"
+
+
+// One band is drawn while the other is sent
+static uint8_t band_buffers[2][BAND_PAGE_COUNT][SSD1306_WIDTH];
+
+
+uint8_t
+band_render(band_draw draw, void* context) {
+	// The whole screen, the bands follow each other in the controller's RAM,
+	// in as many windows as its pages wrap around. Nothing is drawn nor sent
+	// if the window cannot be set.
+	uint8_t window_left = ssd1306_set_screen_window(0, SSD1306_WIDTH - 1, 0, SSD1306_PAGE_COUNT - 1);
+	if (window_left == 0)
+		return 0;
+
+	uint8_t ret = 1;
+	uint8_t index = 0;
+	for(uint8_t page = 0; page < SSD1306_PAGE_COUNT; page += BAND_PAGE_COUNT, index ^= 1) {
+		struct band band = { page, SSD1306_PAGE_COUNT - page, band_buffers[index] };
+		if (band.page_count > BAND_PAGE_COUNT)
+			band.page_count = BAND_PAGE_COUNT;
+
+		// The buffer was sent two bands ago, ssd1306_start_data waited for it
+		memset(band.pages, 0, band.page_count * SSD1306_WIDTH);
+		draw(&band, context);
+
+		// Waits for the previous band, then sends this one in the background,
+		// the next window once the current one is full
+		for(uint8_t sent = 0; sent < band.page_count; ) {
+			if (window_left == 0) {
+				window_left = ssd1306_set_screen_window(0, SSD1306_WIDTH - 1, page + sent, SSD1306_PAGE_COUNT - 1);
+				if (window_left == 0) {
+					ssd1306_wait();
+					return 0;
+				}
+			}
+
+			uint8_t count = band.page_count - sent;
+			if (count > window_left)
+				count = window_left;
+
+			ret &= ssd1306_start_data(&band.pages[sent][0], count * SSD1306_WIDTH);
+			sent += count;
+			window_left -= count;
+		}
+	}
+	ret &= ssd1306_wait();
+
+	// Job done
+	return ret;
+}
@@ -0,0 +1,46 @@
+#ifndef BAND_H
+#define BAND_H
+
+#include <stdint.h>
+
+#include "ssd1306.h"
+
+
+// --- SSD1306 band rendering -------------------------------------------------
+//
+// Draws a frame without a copy of the whole screen in RAM. The screen is cut
+// in bands of BAND_PAGE_COUNT pages, and the draw callback is called once per
+// band, top to bottom, to draw the frame clipped to that band. Each band is
+// sent as soon as it is drawn, while the next one is drawn in a second
+// buffer : the transfer goes on in the TWI or SPI interrupt meanwhile.
+//
+// A 128x64 frame takes 2 x 128 bytes of RAM with the default single page
+// bands, instead of 1024 bytes for a framebuffer, but each frame is drawn and
+// sent whole.
+
+#ifndef BAND_PAGE_COUNT
+#define BAND_PAGE_COUNT 1
+#endif
+
+#define BAND_SIZE (BAND_PAGE_COUNT * SSD1306_WIDTH)
+
+
+// Pages [first_page, first_page + page_count) of the screen, in the
+// controller's layout. The framebuffer is a band of all the pages.
+struct band {
+	uint8_t first_page;
+	uint8_t page_count;
+	uint8_t (*pages)[SSD1306_WIDTH];
+};
+
+
+// Draws the frame clipped to the band, which is cleared beforehand
+typedef void (*band_draw)(const struct band* band, void* context);
+
+
+// Draws a whole frame band by band, and sends it. Returns 0 on failure.
+uint8_t
+band_render(band_draw draw, void* context);
+
+
+#endif /* BAND_H */
@@ -0,0 +1,63 @@
+#include <avr/io.h>
+#include <util/delay.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "baud.h"
+#include "uart.h"
+
+
+// Waits for "SYNC", returns 0 on timeout
+static uint8_t
+baud_wait_sync() {
+	static const char sync[] = "SYNC";
+	uint8_t matched = 0;
+
+	for(uint16_t i = BAUD_SYNC_TIMEOUT_MS; i != 0; --i) {
+		char c;
+		while(uart_try_read(&c, 1)) {
+			if (c == sync[matched]) {
+				if (++matched == sizeof(sync) - 1)
+					return 1;
+			}
+			else
+				matched = (c == sync[0]);
+		}
+
+		_delay_ms(1);
+	}
+
+	return 0;
+}
+
+
+uint8_t
+baud_handle_request(const char* line) {
+	if (strncmp(line, "BAUD ", 5) != 0)
+		return 0;
+
+	// Check that the rate can be reached, INT16_MAX if it cannot at all
+	uint32_t baud = strtoul(line + 5, NULL, 10);
+	int16_t error = (baud == 0) ? INT16_MAX : uart_baud_error(baud);
+	if (abs(error) > UART_BAUD_MAX_ERROR) {
+		fprintf(&uart_output, "ERR %lu %d\r\n", baud, error);
+		return 1;
+	}
+
+	// Switch, uart_set_baud waits until the answer is sent
+	uint32_t previous_baud = uart_get_baud();
+	fprintf(&uart_output, "OK %lu %d\r\n", baud, error);
+	uart_set_baud(baud);
+
+	// Both sides should talk at the new rate now, go back if they do not.
+	// Nothing was sent since the switch, uart_set_baud does not wait.
+	if (!baud_wait_sync()) {
+		uart_set_baud(previous_baud);
+		return 1;
+	}
+
+	// Job done
+	fprintf(&uart_output, "SYNC %lu\r\n", baud);
+	return 1;
+}
@@ -0,0 +1,28 @@
+#ifndef BAUD_H
+#define BAUD_H
+
+#include <stdint.h>
+
+
+// --- Baud rate negotiation --------------------------------------------------
+//
+// Both sides start at a safe rate, ie. 9600, then
+//
+// 1. the host sends "BAUD <rate>"
+// 2. we answer "OK <rate> <error>", error in 1/1000 of the rate, or
+//    "ERR <rate> <error>" if the rate cannot be reached accurately enough
+// 3. both sides switch to the new rate
+// 4. the host sends "SYNC" until we answer "SYNC <rate>"
+//
+// If "SYNC" does not come within BAUD_SYNC_TIMEOUT_MS, we go back to the
+// previous rate, so that a failed switch does not leave the link dead.
+
+#define BAUD_SYNC_TIMEOUT_MS 2000
+
+
+// Handles a line received on the UART, returns 0 if it is not a BAUD request
+uint8_t
+baud_handle_request(const char* line);
+
+
+#endif /* BAUD_H */
@@ -0,0 +1,61 @@
+import sys
+import math
+import argparse
+
+
+def design(kind, cutoff, rate, q):
+    # Audio EQ cookbook (R. Bristow-Johnson), normalized by a0
+    w = 2 * math.pi * cutoff / rate
+    alpha = math.sin(w) / (2 * q)
+    cos_w = math.cos(w)
+
+    if kind == 'lowpass':
+        b = [(1 - cos_w) / 2, 1 - cos_w, (1 - cos_w) / 2]
+    elif kind == 'highpass':
+        b = [(1 + cos_w) / 2, -(1 + cos_w), (1 + cos_w) / 2]
+    elif kind == 'bandpass':
+        b = [alpha, 0., -alpha]
+    else:
+        b = [1., -2 * cos_w, 1.]
+    a = [1 + alpha, -2 * cos_w, 1 - alpha]
+
+    return [x / a[0] for x in b], [x / a[0] for x in a[1:]]
+
+
+def to_q14(x):
+    return int(round(x * 16384))
+
+
+def main():
+    # Command line arguments
+    parser = argparse.ArgumentParser(description = 'Compute the coefficients of a biquad filter, as a struct dsp_biquad initializer')
+    parser.add_argument('--name', default = 'filter')
+    parser.add_argument('--q', type = float, default = 1 / math.sqrt(2), help = 'quality factor, 0.707 for a flat response')
+    parser.add_argument('type', choices = ['lowpass', 'highpass', 'bandpass', 'notch'])
+    parser.add_argument('cutoff', type = float, help = 'cutoff or center frequency, in Hz')
+    parser.add_argument('rate', type = float, help = 'sample rate, in Hz')
+
+    args = parser.parse_args()
+    if not 0 < args.cutoff < args.rate / 2:
+        parser.error('the cutoff should be between 0 and half the sample rate')
+
+    b, a = design(args.type, args.cutoff, args.rate, args.q)
+    coefficients = [to_q14(x) for x in b + a]
+    if any(not -32768 <= x <= 32767 for x in coefficients):
+        parser.error('coefficients out of the Q14 range')
+
+    # Gain at DC and at half the sample rate, with the rounded coefficients
+    q14 = [x / 16384 for x in coefficients]
+    dc = sum(q14[:3]) / (1 + q14[3] + q14[4])
+    nyquist = (q14[0] - q14[1] + q14[2]) / (1 - q14[3] + q14[4])
+    print(f'gain {dc:.3f} at 0 Hz, {nyquist:.3f} at {args.rate / 2:g} Hz', file = sys.stderr)
+
+    # Generate C code
+    print(f'// {args.type}, {args.cutoff:g} Hz at {args.rate:g} Hz, Q {args.q:.3f}')
+    print(f'struct dsp_biquad {args.name} = {{')
+    print('\t' + ', '.join(str(x) for x in coefficients))
+    print('};')
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,105 @@
+#include <avr/io.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "console.h"
+#include "gfx.h"
+#include "ssd1306.h"
+
+
+static const __flash struct font* console_font;
+
+// The line being printed, drawn as a single page band
+static uint8_t console_line[1][SSD1306_WIDTH];
+static uint8_t console_column;  // Where the next character goes
+static uint8_t console_pending; // The line is not on the controller as it is
+
+// Pages of the controller's RAM
+static uint8_t console_page;    // Where the current line goes
+static uint8_t console_top;     // Shown at the top of the screen
+
+// Lines from the top of the screen to the current one, up to
+// SSD1306_PAGE_COUNT + 1 until the current line is scrolled in
+static uint8_t console_line_count;
+
+
+// Sends the current line, then starts a blank one on the next page
+static uint8_t
+console_newline() {
+	uint8_t ret = console_flush();
+
+	console_page = (console_page + 1) % SSD1306_RAM_PAGE_COUNT;
+	console_line_count += 1;
+	memset(console_line, 0, sizeof(console_line));
+	console_column = 0;
+
+	// The page still holds a line that went off the screen
+	console_pending = 1;
+
+	return ret;
+}
+
+
+uint8_t
+console_init(const __flash struct font* font) {
+	console_font = font;
+	memset(console_line, 0, sizeof(console_line));
+	console_column = 0;
+	console_pending = 0;
+	console_page = 0;
+	console_top = 0;
+	console_line_count = 1;
+
+	return
+		ssd1306_set_start_line(0) &&
+		ssd1306_clear();
+}
+
+
+uint8_t
+console_flush(void) {
+	if (!console_pending)
+		return 1;
+	console_pending = 0;
+
+	uint8_t ret =
+		ssd1306_set_window(0, SSD1306_WIDTH - 1, console_page, console_page) &&
+		ssd1306_send_data(console_line[0], SSD1306_WIDTH);
+
+	// Below the screen, scroll it in. When the screen shows all the pages,
+	// the line went to the top page, which then becomes the bottom one.
+	if (console_line_count > SSD1306_PAGE_COUNT) {
+		console_line_count = SSD1306_PAGE_COUNT;
+		console_top = (console_top + 1) % SSD1306_RAM_PAGE_COUNT;
+		ret &= ssd1306_set_start_line(8 * console_top);
+	}
+
+	// Job done
+	return ret;
+}
+
+
+int
+console_putchar(char c, FILE* stream) {
+	if (c == '\n')
+		return console_newline() ? 0 : -1;
+
+	uint8_t advance = font_get_advance(console_font, c);
+	if (advance == 0)
+		return 0;
+
+	// Wrap when the glyph does not fit, its spacing can be left out
+	if ((console_column + advance - console_font->spacing > SSD1306_WIDTH) && !console_newline())
+		return -1;
+
+	struct band band = { 0, 1, console_line };
+	font_draw_char(&band, console_column, 0, console_font, c, GFX_SET);
+	console_column += advance;
+	console_pending = 1;
+
+	return 0;
+}
+
+
+FILE console_output =
+	FDEV_SETUP_STREAM(console_putchar, NULL, _FDEV_SETUP_WRITE);
@@ -0,0 +1,39 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "font.h"
+
+
+// --- Text console on the SSD1306 --------------------------------------------
+//
+// A stdio stream printing lines of text, one page per line, with a font at
+// most 8 rows high. The controller's RAM holds 8 pages, more than a 128x32
+// screen shows : a line is drawn in RAM, then sent to the page right below
+// the screen, and the screen scrolls by one line with the start line
+// command. A 128x64 screen shows all 8 pages, the line goes to the top one,
+// which the scroll turns into the bottom one. Nothing already shown is sent
+// again, a line costs a window, 128 data bytes and the scroll command,
+// whatever the screen size.
+//
+// A line is sent when it ends with '\n', when the next character does not
+// fit, or with console_flush. '\r' is ignored. The console takes over the
+// start line and the window, set them back to use the screen otherwise.
+
+// Clears the screen, and starts at its top
+uint8_t
+console_init(const __flash struct font* font);
+
+// Sends the current line, returns 0 on failure
+uint8_t
+console_flush(void);
+
+int
+console_putchar(char c, FILE* stream);
+
+extern FILE console_output;
+
+
+#endif /* CONSOLE_H */
@@ -0,0 +1,35 @@
+#ifndef CYCLES_H
+#define CYCLES_H
+
+#include <avr/io.h>
+#include <stdint.h>
+
+
+// --- Cycle counting with Timer1 ---------------------------------------------
+//
+// Timer1 runs without prescaler, thus one tick per CPU cycle, and wraps after
+// 65536 cycles (4 msec at 16 MHz). It takes over Timer1, for benchmarks only.
+// Measure with interrupts disabled, and subtract the cost of an empty
+// measurement, given by cycles_overhead.
+
+static inline void
+cycles_init(void) {
+	TCCR1A = 0;
+	TCCR1B = _BV(CS10);
+}
+
+
+static inline uint16_t
+cycles_now(void) {
+	return TCNT1;
+}
+
+
+static inline uint16_t
+cycles_overhead(void) {
+	uint16_t start = cycles_now();
+	return cycles_now() - start;
+}
+
+
+#endif /* CYCLES_H */
@@ -0,0 +1,205 @@
+#include <avr/io.h>
+#include <string.h>
+
+#include "dsp.h"
+
+
+_Static_assert(DSP_MEDIAN_MAX_SIZE <= 255, "median window size fits in a byte");
+
+
+// --- Single-pole IIR --------------------------------------------------------
+
+void
+dsp_iir1_init(struct dsp_iir1* filter, uint8_t alpha, int16_t value) {
+	filter->y = (int32_t)value << 8;
+	filter->alpha = alpha;
+}
+
+
+void
+dsp_iir1(struct dsp_iir1* filter, int16_t* samples, uint8_t count) {
+	int32_t y = filter->y;
+	uint8_t alpha = filter->alpha;
+
+	for(uint8_t i = 0; i < count; ++i) {
+		y += dsp_mul_s16_u8(samples[i] - (int16_t)(y >> 8), alpha);
+		samples[i] = y >> 8;
+	}
+
+	filter->y = y;
+}
+
+
+// --- Biquad -----------------------------------------------------------------
+
+void
+dsp_biquad_reset(struct dsp_biquad* filter) {
+	filter->x1 = filter->x2 = 0;
+	filter->y1 = filter->y2 = 0;
+	filter->error = 0;
+}
+
+
+void
+dsp_biquad(struct dsp_biquad* filter, int16_t* samples, uint8_t count) {
+	int16_t x1 = filter->x1, x2 = filter->x2;
+	int16_t y1 = filter->y1, y2 = filter->y2;
+	uint16_t error = filter->error;
+
+	for(uint8_t i = 0; i < count; ++i) {
+		int16_t x = samples[i];
+		int32_t acc = error;
+		acc += (int32_t)filter->b0 * x;
+		acc += (int32_t)filter->b1 * x1;
+		acc += (int32_t)filter->b2 * x2;
+		acc -= (int32_t)filter->a1 * y1;
+		acc -= (int32_t)filter->a2 * y2;
+
+		// What the shift drops goes with the next output, so that rounding
+		// errors do not pile up through the feedback
+		error = acc & 0x3fff;
+		acc >>= 14;
+
+		// Saturate, rather than wrap around
+		if (acc > INT16_MAX)
+			acc = INT16_MAX;
+		else if (acc < INT16_MIN)
+			acc = INT16_MIN;
+
+		x2 = x1;
+		x1 = x;
+		y2 = y1;
+		y1 = acc;
+		samples[i] = acc;
+	}
+
+	filter->x1 = x1;
+	filter->x2 = x2;
+	filter->y1 = y1;
+	filter->y2 = y2;
+	filter->error = error;
+}
+
+
+// --- Moving average ---------------------------------------------------------
+
+void
+dsp_average_init(struct dsp_average* filter, int16_t* history, uint8_t shift, int16_t value) {
+	filter->history = history;
+	filter->shift = shift;
+	filter->index = 0;
+	filter->sum = (int32_t)value << shift;
+
+	for(uint16_t i = 0; i < ((uint16_t)1 << shift); ++i)
+		history[i] = value;
+}
+
+
+void
+dsp_average(struct dsp_average* filter, int16_t* samples, uint8_t count) {
+	uint8_t mask = ((uint16_t)1 << filter->shift) - 1;
+
+	for(uint8_t i = 0; i < count; ++i) {
+		// The oldest sample leaves the sum, the new one enters it
+		int16_t* slot = &filter->history[filter->index];
+		filter->sum += samples[i] - *slot;
+		*slot = samples[i];
+		filter->index = (filter->index + 1) & mask;
+
+		samples[i] = filter->sum >> filter->shift;
+	}
+}
+
+
+// --- CIC decimator ----------------------------------------------------------
+
+void
+dsp_cic_init(struct dsp_cic* filter, uint8_t shift) {
+	memset(filter, 0, sizeof(*filter));
+	filter->shift = shift;
+	filter->count = (uint16_t)1 << shift;
+}
+
+
+uint8_t
+dsp_cic(struct dsp_cic* filter, const int16_t* samples, uint8_t count, int16_t* out) {
+	uint8_t ret = 0;
+
+	for(uint8_t i = 0; i < count; ++i) {
+		// Integrators, at the input rate
+		filter->integrators[0] += (uint32_t)(int32_t)samples[i];
+		filter->integrators[1] += filter->integrators[0];
+		if (--filter->count != 0)
+			continue;
+		filter->count = (uint16_t)1 << filter->shift;
+
+		// Combs, at the output rate
+		uint32_t comb0 = filter->integrators[1] - filter->combs[0];
+		filter->combs[0] = filter->integrators[1];
+		uint32_t comb1 = comb0 - filter->combs[1];
+		filter->combs[1] = comb0;
+
+		out[ret++] = (int32_t)comb1 >> (2 * filter->shift);
+	}
+
+	return ret;
+}
+
+
+// --- Median -----------------------------------------------------------------
+
+void
+dsp_median_init(struct dsp_median* filter, uint8_t size, int16_t value) {
+	filter->size = size;
+	filter->index = 0;
+	for(uint8_t i = 0; i < size; ++i)
+		filter->history[i] = filter->sorted[i] = value;
+}
+
+
+void
+dsp_median(struct dsp_median* filter, int16_t* samples, uint8_t count) {
+	int16_t* sorted = filter->sorted;
+	uint8_t size = filter->size;
+
+	for(uint8_t i = 0; i < count; ++i) {
+		int16_t x = samples[i];
+		int16_t old = filter->history[filter->index];
+		filter->history[filter->index] = x;
+		if (++filter->index == size)
+			filter->index = 0;
+
+		// Where the oldest sample was in order, then move the ones in
+		// between to make room for the new one
+		uint8_t j = 0;
+		while(sorted[j] != old)
+			++j;
+		for( ; (j > 0) && (sorted[j - 1] > x); --j)
+			sorted[j] = sorted[j - 1];
+		for( ; (j + 1 < size) && (sorted[j + 1] < x); ++j)
+			sorted[j] = sorted[j + 1];
+		sorted[j] = x;
+
+		samples[i] = sorted[size / 2];
+	}
+}
+
+
+// --- Schmitt trigger --------------------------------------------------------
+
+uint8_t
+dsp_schmitt(struct dsp_schmitt* trigger, const int16_t* samples, uint8_t count) {
+	uint8_t state = trigger->state;
+
+	for(uint8_t i = 0; i < count; ++i) {
+		if (state) {
+			if (samples[i] < trigger->low)
+				state = 0;
+		}
+		else if (samples[i] > trigger->high)
+			state = 1;
+	}
+
+	trigger->state = state;
+	return state;
+}
@@ -0,0 +1,134 @@
+#ifndef DSP_H
+#define DSP_H
+
+#include <stdint.h>
+
+
+// --- Fixed-point filters for sample streams ---------------------------------
+//
+// Filters over blocks of samples, as adc_read_block hands them out, in place:
+// each function replaces a block with its output. Samples are signed 16 bits;
+// ADC results fit as they are, the uint16_t buffers of adc.h can be cast. The
+// state lives in a struct, so that the stream goes on block after block.
+//
+// No floating point. The multiplications are the ones the AVR does in
+// hardware, 8x8 bits in 2 cycles: 16x8 bits, 2 of them, for the single-pole
+// IIR, 16x16 bits, 4 of them, for the biquad. Samples should stay within 13
+// bits, +/- 8191, the range of the oversampled ADC results.
+
+// Coefficients with 14 fractional bits, from -2 to 2
+#define DSP_Q14(x) ((int16_t)((x) * 16384.0 + (((x) < 0) ? -0.5 : 0.5)))
+
+
+// 16x8 bits signed by unsigned, as 2 hardware multiplications
+static inline int32_t
+dsp_mul_s16_u8(int16_t a, uint8_t b) {
+	int16_t high = (int8_t)(a >> 8) * b;
+	uint16_t low = (uint8_t)a * b;
+	return ((int32_t)high << 8) + low;
+}
+
+
+// Single-pole low-pass, y += alpha * (x - y). alpha is in 1/256, about
+// 256 * 2 * pi * fc / fs for a cutoff fc well below the sample rate fs.
+struct dsp_iir1 {
+	int32_t y;     // Output, 8 fractional bits
+	uint8_t alpha;
+};
+
+void
+dsp_iir1_init(struct dsp_iir1* filter, uint8_t alpha, int16_t value);
+
+void
+dsp_iir1(struct dsp_iir1* filter, int16_t* samples, uint8_t count);
+
+
+// Second order section, direct form I, coefficients made with DSP_Q14, a0
+// being 1: y = b0 x + b1 x1 + b2 x2 - a1 y1 - a2 y2. Computed with 14
+// fractional bits, saturated, the fraction dropped from an output is added
+// to the next one. See biquad-to-code.py.
+struct dsp_biquad {
+	int16_t b0, b1, b2, a1, a2;
+	int16_t x1, x2, y1, y2;
+	uint16_t error;
+};
+
+// Clears the history, the coefficients are kept
+void
+dsp_biquad_reset(struct dsp_biquad* filter);
+
+void
+dsp_biquad(struct dsp_biquad* filter, int16_t* samples, uint8_t count);
+
+
+// Moving average of 2^shift samples, with a running sum. The history is an
+// array of 2^shift samples, given by the caller.
+struct dsp_average {
+	int16_t* history;
+	int32_t sum;
+	uint8_t index;
+	uint8_t shift;
+};
+
+// The history starts filled with value
+void
+dsp_average_init(struct dsp_average* filter, int16_t* history, uint8_t shift, int16_t value);
+
+void
+dsp_average(struct dsp_average* filter, int16_t* samples, uint8_t count);
+
+
+// Second order CIC decimator: 2 integrators, one output every 2^shift
+// samples, 2 combs. The response of 2 moving averages of 2^shift samples in a
+// row, with no multiplication at all. The gain, 2^(2 * shift), is removed.
+#define DSP_CIC_MAX_SHIFT 7
+
+struct dsp_cic {
+	uint32_t integrators[2]; // Wrap around, which the combs undo
+	uint32_t combs[2];       // Integrator values at the previous output
+	uint8_t count;           // Samples left for the current output
+	uint8_t shift;
+};
+
+void
+dsp_cic_init(struct dsp_cic* filter, uint8_t shift);
+
+// Writes an output every 2^shift samples, returns the number of outputs. out
+// can be samples.
+uint8_t
+dsp_cic(struct dsp_cic* filter, const int16_t* samples, uint8_t count, int16_t* out);
+
+
+// Median of the last size samples, size odd. Removes spikes shorter than
+// half the window, where averaging would only spread them.
+#define DSP_MEDIAN_MAX_SIZE 9
+
+struct dsp_median {
+	int16_t history[DSP_MEDIAN_MAX_SIZE]; // Arrival order
+	int16_t sorted[DSP_MEDIAN_MAX_SIZE];  // Same samples, in order
+	uint8_t size;
+	uint8_t index; // Oldest sample of the history
+};
+
+// The window starts filled with value
+void
+dsp_median_init(struct dsp_median* filter, uint8_t size, int16_t value);
+
+void
+dsp_median(struct dsp_median* filter, int16_t* samples, uint8_t count);
+
+
+// Comparator with hysteresis: goes to 1 above high, back to 0 below low, and
+// stays as it is in between, thus does not chatter around a threshold.
+struct dsp_schmitt {
+	int16_t low;
+	int16_t high;
+	uint8_t state;
+};
+
+// Returns the state after the block, the samples are left as they are
+uint8_t
+dsp_schmitt(struct dsp_schmitt* trigger, const int16_t* samples, uint8_t count);
+
+
+#endif /* DSP_H */
@@ -0,0 +1,64 @@
+#include <avr/io.h>
+
+#include "font.h"
+#include "gfx.h"
+
+
+// Glyph of a character, returns its width in columns, 0 if the font lacks it
+static uint8_t
+font_get_glyph(const __flash struct font* font, char c, const __flash uint8_t** glyph) {
+	uint8_t index = (uint8_t)c - font->first;
+	if (index >= font->count)
+		return 0;
+
+	uint8_t page_count = (font->height + 7) / 8;
+	if (font->width != 0) {
+		*glyph = font->data + (uint16_t)index * font->width * page_count;
+		return font->width;
+	}
+
+	uint16_t offset = font->offsets[index];
+	*glyph = font->data + offset * page_count;
+	return font->offsets[index + 1] - offset;
+}
+
+
+uint8_t
+font_get_advance(const __flash struct font* font, char c) {
+	const __flash uint8_t* glyph;
+	uint8_t width = font_get_glyph(font, c, &glyph);
+	return (width != 0) ? width + font->spacing : 0;
+}
+
+
+uint16_t
+font_get_width(const __flash struct font* font, const char* str) {
+	uint16_t width = 0;
+	for( ; *str != '\0'; ++str)
+		width += font_get_advance(font, *str);
+
+	return width;
+}
+
+
+uint8_t
+font_draw_char(const struct band* band, int16_t x, int16_t y,
+               const __flash struct font* font, char c, uint8_t op) {
+	const __flash uint8_t* glyph;
+	uint8_t width = font_get_glyph(font, c, &glyph);
+	if (width == 0)
+		return 0;
+
+	gfx_blit(band, x, y, glyph, width, font->height, op);
+	return width + font->spacing;
+}
+
+
+int16_t
+font_draw_string(const struct band* band, int16_t x, int16_t y,
+                 const __flash struct font* font, const char* str, uint8_t op) {
+	for( ; *str != '\0'; ++str)
+		x += font_draw_char(band, x, y, font, *str, op);
+
+	return x;
+}
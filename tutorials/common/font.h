@@ -0,0 +1,52 @@
+#ifndef FONT_H
+#define FONT_H
+
+#include <stdint.h>
+
+#include "band.h"
+
+
+// --- Fonts ------------------------------------------------------------------
+//
+// Fonts live in flash memory, glyphs in the SSD1306 page layout, as sprites
+// for gfx_blit: (height + 7) / 8 pages of the glyph's width. Glyphs of a
+// fixed font are all width columns wide. Those of a proportional font
+// (width is 0) follow each other, offsets gives the first column of each,
+// and the end of the last one.
+
+struct font {
+	uint8_t height;                  // Rows
+	uint8_t first;                   // First character
+	uint8_t count;                   // Number of characters
+	uint8_t width;                   // Columns, 0 for a proportional font
+	uint8_t spacing;                 // Blank columns after each glyph
+	const __flash uint16_t* offsets; // count + 1 columns, proportional only
+	const __flash uint8_t* data;
+};
+
+
+// 5x7 fonts, 95 characters from space to ~, in font-5x7.c
+extern const __flash struct font font_5x7;
+extern const __flash struct font font_5x7_proportional;
+
+
+// Columns taken by a character, spacing included, 0 if the font lacks it
+uint8_t
+font_get_advance(const __flash struct font* font, char c);
+
+// Columns taken by a string, spacing included
+uint16_t
+font_get_width(const __flash struct font* font, const char* str);
+
+// Draws a character with its top-left corner at (x, y), returns its advance
+uint8_t
+font_draw_char(const struct band* band, int16_t x, int16_t y,
+               const __flash struct font* font, char c, uint8_t op);
+
+// Draws a string on a single line, returns the column after its end
+int16_t
+font_draw_string(const struct band* band, int16_t x, int16_t y,
+                 const __flash struct font* font, const char* str, uint8_t op);
+
+
+#endif /* FONT_H */
@@ -0,0 +1,175 @@
+#include <avr/io.h>
+#include <string.h>
+
+#include "framebuffer.h"
+#include "ssd1306.h"
+
+
+uint8_t framebuffer[SSD1306_PAGE_COUNT][SSD1306_WIDTH];
+
+// One bit per block of each page, set when the block changed
+static uint16_t framebuffer_dirty[SSD1306_PAGE_COUNT];
+
+static struct framebuffer_stats framebuffer_stats;
+
+
+// A run of dirty blocks, from first to last included
+struct framebuffer_run {
+	uint8_t first;
+	uint8_t last;
+};
+
+// Runs are separated by at least one clean block
+#define FRAMEBUFFER_MAX_RUNS ((FRAMEBUFFER_BLOCK_COUNT + 1) / 2)
+
+// Every block of a page, and none past the screen's width
+#define FRAMEBUFFER_ALL_BLOCKS ((uint16_t)(0xffffU >> (16 - FRAMEBUFFER_BLOCK_COUNT)))
+
+
+static inline uint16_t
+framebuffer_block_mask(uint8_t first_column, uint8_t last_column) {
+	uint8_t first = first_column / FRAMEBUFFER_BLOCK_WIDTH;
+	uint8_t last = last_column / FRAMEBUFFER_BLOCK_WIDTH;
+	return (uint16_t)(0xffffU << first) & (uint16_t)(0xffffU >> (15 - last));
+}
+
+
+// Splits a page's dirty bits in runs, merging the runs separated by fewer
+// clean bytes than the cost of a new window. Returns the number of runs.
+static uint8_t
+framebuffer_get_runs(uint16_t mask, struct framebuffer_run* runs) {
+	uint8_t count = 0;
+	uint8_t gap = 0; // Clean blocks since the last dirty one
+
+	for(uint8_t i = 0; mask != 0; ++i, mask >>= 1) {
+		if (!(mask & 1)) {
+			gap += 1;
+			continue;
+		}
+
+		if ((count == 0) || (gap * FRAMEBUFFER_BLOCK_WIDTH > FRAMEBUFFER_WINDOW_COST))
+			runs[count++].first = i;
+		runs[count - 1].last = i;
+		gap = 0;
+	}
+
+	return count;
+}
+
+
+// Returns 1 if the page's dirty bits are the single given run
+static uint8_t
+framebuffer_is_same_run(uint8_t page, const struct framebuffer_run* run) {
+	struct framebuffer_run runs[FRAMEBUFFER_MAX_RUNS];
+	return
+		(framebuffer_get_runs(framebuffer_dirty[page], runs) == 1) &&
+		(runs[0].first == run->first) &&
+		(runs[0].last == run->last);
+}
+
+
+void
+framebuffer_clear(void) {
+	memset(framebuffer, 0, sizeof(framebuffer));
+	for(uint8_t page = 0; page < SSD1306_PAGE_COUNT; ++page)
+		framebuffer_dirty[page] = FRAMEBUFFER_ALL_BLOCKS;
+}
+
+
+void
+framebuffer_load(const __flash uint8_t* bitmap) {
+	uint8_t* ptr = &framebuffer[0][0];
+	for(uint16_t i = 0; i < SSD1306_BUFFER_SIZE; ++i)
+		ptr[i] = bitmap[i];
+
+	for(uint8_t page = 0; page < SSD1306_PAGE_COUNT; ++page)
+		framebuffer_dirty[page] = FRAMEBUFFER_ALL_BLOCKS;
+}
+
+
+void
+framebuffer_mark(uint8_t page, uint8_t first_column, uint8_t last_column) {
+	framebuffer_dirty[page] |= framebuffer_block_mask(first_column, last_column);
+}
+
+
+void
+framebuffer_set_pixel(uint8_t x, uint8_t y, uint8_t on) {
+	if ((x >= SSD1306_WIDTH) || (y >= SSD1306_HEIGHT))
+		return;
+
+	uint8_t page = y / 8;
+	uint8_t mask = _BV(y % 8);
+	if (on)
+		framebuffer[page][x] |= mask;
+	else
+		framebuffer[page][x] &= ~mask;
+
+	framebuffer_dirty[page] |= (uint16_t)1 << (x / FRAMEBUFFER_BLOCK_WIDTH);
+}
+
+
+uint8_t
+framebuffer_flush(void) {
+	// Pages a scroll moved in the controller's RAM are sent again
+	uint8_t stale_pages = ssd1306_take_stale_pages();
+	for(uint8_t page = 0; page < SSD1306_PAGE_COUNT; ++page)
+		if (stale_pages & _BV(ssd1306_get_ram_page(page)))
+			framebuffer_mark(page, 0, SSD1306_WIDTH - 1);
+
+	for(uint8_t page = 0; page < SSD1306_PAGE_COUNT; ) {
+		struct framebuffer_run runs[FRAMEBUFFER_MAX_RUNS];
+		uint8_t run_count = framebuffer_get_runs(framebuffer_dirty[page], runs);
+		if (run_count == 0) {
+			++page;
+			continue;
+		}
+
+		// The following pages with the same single run share the window,
+		// unless they wrap around the controller's RAM
+		uint8_t ram_page = ssd1306_get_ram_page(page);
+		uint8_t last_page = page;
+		if (run_count == 1)
+			while((last_page + 1 < SSD1306_PAGE_COUNT) &&
+			      (ssd1306_get_ram_page(last_page + 1) != 0) &&
+			      framebuffer_is_same_run(last_page + 1, runs))
+				++last_page;
+
+		for(uint8_t i = 0; i < run_count; ++i) {
+			uint8_t first_column = runs[i].first * FRAMEBUFFER_BLOCK_WIDTH;
+			uint8_t width = (runs[i].last - runs[i].first + 1) * FRAMEBUFFER_BLOCK_WIDTH;
+			if (!ssd1306_set_window(first_column, first_column + width - 1, ram_page, ram_page + last_page - page))
+				return 0;
+			framebuffer_stats.windows += 1;
+
+			// Full width, the pages are contiguous in RAM
+			if (width == SSD1306_WIDTH) {
+				uint16_t size = (last_page - page + 1) * SSD1306_WIDTH;
+				if (!ssd1306_send_data(framebuffer[page], size))
+					return 0;
+				framebuffer_stats.data_bytes += size;
+				continue;
+			}
+
+			for(uint8_t j = page; j <= last_page; ++j) {
+				if (!ssd1306_send_data(&framebuffer[j][first_column], width))
+					return 0;
+				framebuffer_stats.data_bytes += width;
+			}
+		}
+
+		// Those pages are up to date
+		for( ; page <= last_page; ++page)
+			framebuffer_dirty[page] = 0;
+	}
+
+	// Job done
+	return 1;
+}
+
+
+void
+framebuffer_get_stats(struct framebuffer_stats* stats) {
+	*stats = framebuffer_stats;
+	memset(&framebuffer_stats, 0, sizeof(framebuffer_stats));
+}
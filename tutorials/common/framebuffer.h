@@ -0,0 +1,69 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <stdint.h>
+
+#include "ssd1306.h"
+
+
+// --- SSD1306 framebuffer ----------------------------------------------------
+//
+// A copy of the screen in RAM, in the controller's page layout, with a record
+// of what changed since the last framebuffer_flush. Each page is cut in
+// blocks of FRAMEBUFFER_BLOCK_WIDTH columns, with one dirty bit per block.
+//
+// framebuffer_flush only sends the dirty blocks. Each run of dirty blocks
+// costs a window command and a data transfer, about FRAMEBUFFER_WINDOW_COST
+// bytes on the bus on top of the data. Runs closer than that are merged, as
+// sending the clean blocks in between is cheaper. Pages with the same run
+// share a single window.
+//
+// The framebuffer holds the screen as it is shown: its pages go to the pages
+// of the controller's RAM on screen, after a start line or vertical offset
+// change, and the pages a scroll moved are sent again in full.
+
+#define FRAMEBUFFER_BLOCK_WIDTH 8
+#define FRAMEBUFFER_BLOCK_COUNT (SSD1306_WIDTH / FRAMEBUFFER_BLOCK_WIDTH)
+
+// Window command: address, control byte, 6 command bytes. Data transfer:
+// address, control byte. Plus a START and a STOP for each, about one byte.
+#define FRAMEBUFFER_WINDOW_COST 11
+
+_Static_assert(FRAMEBUFFER_BLOCK_COUNT <= 16, "one dirty bit per block, 16 blocks per page at most");
+
+
+// Bus traffic of framebuffer_flush, cleared by framebuffer_get_stats
+struct framebuffer_stats {
+	uint16_t windows;    // Window commands sent
+	uint16_t data_bytes; // Data bytes sent
+};
+
+
+extern uint8_t framebuffer[SSD1306_PAGE_COUNT][SSD1306_WIDTH];
+
+
+// Fills with zeros, everything is dirty
+void
+framebuffer_clear(void);
+
+// Copy a full screen from the flash memory, everything is dirty
+void
+framebuffer_load(const __flash uint8_t* bitmap);
+
+// Records that columns [first_column, last_column] of a page changed
+void
+framebuffer_mark(uint8_t page, uint8_t first_column, uint8_t last_column);
+
+void
+framebuffer_set_pixel(uint8_t x, uint8_t y, uint8_t on);
+
+// Sends what changed, returns 0 on failure, then the dirty blocks are kept
+uint8_t
+framebuffer_flush(void);
+
+// Copy the bus traffic counters, then reset them
+void
+framebuffer_get_stats(struct framebuffer_stats* stats);
+
+
+#endif /* FRAMEBUFFER_H */
@@ -0,0 +1,310 @@
+#include <avr/io.h>
+#include <stddef.h>
+
+#include "gfx.h"
+
+
+// Rows are counted from the top of the screen, y >> 3 is the page of a row,
+// negative rows included, as avr-gcc shifts signed integers arithmetically
+
+
+// --- Raster operations ------------------------------------------------------
+
+// A byte of the screen becomes (byte & keep) ^ flip, with
+// keep = (bits & keep_and) ^ keep_xor and flip = bits & flip_and
+struct gfx_rop {
+	uint8_t keep_and;
+	uint8_t keep_xor;
+	uint8_t flip_and;
+};
+
+
+// mask is the rows covered, bits the rows on, within the mask
+static inline struct gfx_rop
+gfx_get_rop(uint8_t op, uint8_t mask) {
+	struct gfx_rop rop = { 0xff, 0xff, 0xff };
+	if (op == GFX_INVERT)
+		rop.keep_and = 0;
+	else if (op != GFX_SET) {
+		rop.flip_and = 0;
+		if (op == GFX_AND)
+			rop.keep_xor = ~mask;
+	}
+
+	return rop;
+}
+
+
+static inline void
+gfx_apply(uint8_t* ptr, const struct gfx_rop* rop, uint8_t bits) {
+	*ptr = (*ptr & ((bits & rop->keep_and) ^ rop->keep_xor)) ^ (bits & rop->flip_and);
+}
+
+
+// Applies the rows of bits to a byte, if it is on the band
+static void
+gfx_apply_bits(const struct band* band, int16_t x, int16_t page, uint8_t bits, uint8_t op) {
+	if ((x < 0) || (x >= SSD1306_WIDTH) || (bits == 0))
+		return;
+	if ((page < band->first_page) || (page >= band->first_page + band->page_count))
+		return;
+
+	struct gfx_rop rop = gfx_get_rop(op, bits);
+	gfx_apply(&band->pages[page - band->first_page][x], &rop, bits);
+}
+
+
+static inline int16_t
+gfx_band_top(const struct band* band) {
+	return 8 * band->first_page;
+}
+
+
+static inline int16_t
+gfx_band_bottom(const struct band* band) {
+	return 8 * (band->first_page + band->page_count);
+}
+
+
+// --- Spans and rectangles ---------------------------------------------------
+
+void
+gfx_set_pixel(const struct band* band, int16_t x, int16_t y, uint8_t op) {
+	gfx_apply_bits(band, x, y >> 3, _BV(y & 7), op);
+}
+
+
+void
+gfx_fill_rect(const struct band* band, int16_t x, int16_t y, uint8_t width, uint8_t height, uint8_t op) {
+	// Clip to the band
+	int16_t x0 = (x < 0) ? 0 : x;
+	int16_t x1 = (x + width > SSD1306_WIDTH) ? SSD1306_WIDTH : x + width;
+	int16_t y0 = (y < gfx_band_top(band)) ? gfx_band_top(band) : y;
+	int16_t y1 = (y + height > gfx_band_bottom(band)) ? gfx_band_bottom(band) : y + height;
+	if ((x0 >= x1) || (y0 >= y1))
+		return;
+
+	// One mask per page, the same for all the columns
+	uint8_t first_page = y0 >> 3;
+	uint8_t last_page = (y1 - 1) >> 3;
+	for(uint8_t page = first_page; page <= last_page; ++page) {
+		uint8_t mask = 0xff;
+		if (page == first_page)
+			mask <<= y0 & 7;
+		if (page == last_page)
+			mask &= 0xff >> (7 - ((y1 - 1) & 7));
+
+		struct gfx_rop rop = gfx_get_rop(op, mask);
+		uint8_t keep = (mask & rop.keep_and) ^ rop.keep_xor;
+		uint8_t flip = mask & rop.flip_and;
+
+		uint8_t* ptr = &band->pages[page - band->first_page][x0];
+		for(uint8_t i = x1 - x0; i != 0; --i, ++ptr)
+			*ptr = (*ptr & keep) ^ flip;
+	}
+}
+
+
+void
+gfx_hline(const struct band* band, int16_t x, int16_t y, uint8_t width, uint8_t op) {
+	gfx_fill_rect(band, x, y, width, 1, op);
+}
+
+
+void
+gfx_vline(const struct band* band, int16_t x, int16_t y, uint8_t height, uint8_t op) {
+	gfx_fill_rect(band, x, y, 1, height, op);
+}
+
+
+void
+gfx_rect(const struct band* band, int16_t x, int16_t y, uint8_t width, uint8_t height, uint8_t op) {
+	if ((width == 0) || (height == 0))
+		return;
+
+	// Each pixel once, for GFX_INVERT
+	gfx_hline(band, x, y, width, op);
+	if (height > 1)
+		gfx_hline(band, x, y + height - 1, width, op);
+	if (height > 2) {
+		gfx_vline(band, x, y + 1, height - 2, op);
+		if (width > 1)
+			gfx_vline(band, x + width - 1, y + 1, height - 2, op);
+	}
+}
+
+
+// --- Lines and circles ------------------------------------------------------
+
+void
+gfx_line(const struct band* band, int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t op) {
+	// Top to bottom
+	if (y0 > y1) {
+		int16_t t;
+		t = x0; x0 = x1; x1 = t;
+		t = y0; y0 = y1; y1 = t;
+	}
+	if ((y1 < gfx_band_top(band)) || (y0 >= gfx_band_bottom(band)))
+		return;
+
+	int16_t dx = (x1 > x0) ? x1 - x0 : x0 - x1;
+	int16_t dy = y1 - y0;
+	int8_t sx = (x1 > x0) ? 1 : -1;
+	int16_t err = dx - dy;
+
+	// Pixels of a same column and page go to the screen as one byte
+	int16_t run_x = x0;
+	int16_t run_page = y0 >> 3;
+	uint8_t run_bits = 0;
+
+	for(int16_t x = x0, y = y0; y < gfx_band_bottom(band); ) {
+		if ((x != run_x) || ((y >> 3) != run_page)) {
+			gfx_apply_bits(band, run_x, run_page, run_bits, op);
+			run_x = x;
+			run_page = y >> 3;
+			run_bits = 0;
+		}
+		run_bits |= _BV(y & 7);
+
+		if ((x == x1) && (y == y1))
+			break;
+
+		int16_t e2 = 2 * err;
+		if (e2 > -dy) {
+			err -= dy;
+			x += sx;
+		}
+		if (e2 < dx) {
+			err += dx;
+			y += 1;
+		}
+	}
+	gfx_apply_bits(band, run_x, run_page, run_bits, op);
+}
+
+
+// (cx +/- a, cy +/- b), each pixel once
+static void
+gfx_plot4(const struct band* band, int16_t cx, int16_t cy, uint8_t a, uint8_t b, uint8_t op) {
+	gfx_set_pixel(band, cx + a, cy + b, op);
+	if (a != 0)
+		gfx_set_pixel(band, cx - a, cy + b, op);
+	if (b != 0) {
+		gfx_set_pixel(band, cx + a, cy - b, op);
+		if (a != 0)
+			gfx_set_pixel(band, cx - a, cy - b, op);
+	}
+}
+
+
+void
+gfx_circle(const struct band* band, int16_t cx, int16_t cy, uint8_t radius, uint8_t op) {
+	if ((cy + radius < gfx_band_top(band)) || (cy - radius >= gfx_band_bottom(band)))
+		return;
+
+	// Midpoint algorithm, one octant mirrored 8 times
+	uint8_t x = radius, y = 0;
+	int16_t err = 1 - radius;
+	while(x >= y) {
+		gfx_plot4(band, cx, cy, x, y, op);
+		if (x != y)
+			gfx_plot4(band, cx, cy, y, x, op);
+
+		y += 1;
+		if (err < 0)
+			err += 2 * y + 1;
+		else {
+			x -= 1;
+			err += 2 * (y - x) + 1;
+		}
+	}
+}
+
+
+void
+gfx_fill_circle(const struct band* band, int16_t cx, int16_t cy, uint8_t radius, uint8_t op) {
+	if ((cy + radius < gfx_band_top(band)) || (cy - radius >= gfx_band_bottom(band)))
+		return;
+
+	// One vertical span per column, drawn a page at a time. Up to a radius
+	// of 255, the sum of the squares needs 32 bits.
+	uint32_t limit = (uint32_t)radius * radius + radius;
+	uint8_t h = radius;
+	for(uint16_t dx = 0; dx <= radius; ++dx) {
+		uint32_t dx2 = (uint32_t)dx * dx;
+		while(dx2 + (uint16_t)h * h > limit)
+			h -= 1;
+
+		// Clipped to the band, the span then fits in a byte
+		int16_t y0 = cy - h;
+		int16_t y1 = cy + h + 1;
+		if (y0 < gfx_band_top(band))
+			y0 = gfx_band_top(band);
+		if (y1 > gfx_band_bottom(band))
+			y1 = gfx_band_bottom(band);
+		if (y0 >= y1)
+			continue;
+
+		gfx_vline(band, cx + dx, y0, y1 - y0, op);
+		if (dx != 0)
+			gfx_vline(band, cx - dx, y0, y1 - y0, op);
+	}
+}
+
+
+// --- Sprites ----------------------------------------------------------------
+
+void
+gfx_blit(const struct band* band, int16_t x, int16_t y,
+         const __flash uint8_t* sprite, uint8_t width, uint8_t height, uint8_t op) {
+	// Clip the columns
+	int16_t x0 = (x < 0) ? 0 : x;
+	int16_t x1 = (x + width > SSD1306_WIDTH) ? SSD1306_WIDTH : x + width;
+	if ((x0 >= x1) || (height == 0))
+		return;
+	uint8_t count = x1 - x0;
+	const __flash uint8_t* column = sprite + (x0 - x);
+
+	// Pages of the band the sprite covers
+	int16_t top_page = y >> 3;
+	int16_t first_page = (top_page < band->first_page) ? band->first_page : top_page;
+	int16_t last_page = (y + height - 1) >> 3;
+	if (last_page >= band->first_page + band->page_count)
+		last_page = band->first_page + band->page_count - 1;
+
+	// Rows of the last sprite page within the sprite
+	uint8_t page_count = (height + 7) / 8;
+	uint8_t last_mask = 0xff >> (8 * page_count - height);
+
+	// A sprite byte times 2^shift: the low byte goes to a page, the high
+	// byte to the next one. The hardware multiplier does it in 2 cycles.
+	uint8_t shift = y & 7;
+	uint8_t factor = _BV(shift);
+
+	for(int16_t page = first_page; page <= last_page; ++page) {
+		// Sprite page i, moved down, and the bottom of page i - 1
+		uint8_t i = page - top_page;
+		const __flash uint8_t* low = NULL;
+		const __flash uint8_t* high = NULL;
+		uint8_t mask = 0;
+		if (i < page_count) {
+			low = column + i * width;
+			mask = (uint8_t)(((i + 1 == page_count) ? last_mask : 0xff) * factor);
+		}
+		if ((shift != 0) && (i > 0)) {
+			high = column + (i - 1) * width;
+			mask |= (uint16_t)((i == page_count) ? last_mask : 0xff) * factor >> 8;
+		}
+
+		struct gfx_rop rop = gfx_get_rop(op, mask);
+		uint8_t* ptr = &band->pages[page - band->first_page][x0];
+		for(uint8_t j = 0; j < count; ++j) {
+			uint8_t bits = 0;
+			if (low)
+				bits = (uint8_t)(low[j] * factor);
+			if (high)
+				bits |= (uint16_t)(high[j] * factor) >> 8;
+			gfx_apply(ptr + j, &rop, bits & mask);
+		}
+	}
+}
@@ -0,0 +1,63 @@
+#ifndef GFX_H
+#define GFX_H
+
+#include <stdint.h>
+
+#include "band.h"
+
+
+// --- 1 bit graphics ---------------------------------------------------------
+//
+// Drawing in the SSD1306 page layout, on a band (see band.h), or on the whole
+// framebuffer with { 0, SSD1306_PAGE_COUNT, framebuffer }, in which case the
+// caller marks what changed with framebuffer_mark. Everything is clipped to
+// the band, so that the same drawing code serves band rendering.
+//
+// Rows within a page are bits of a same byte, thus spans, rectangles and
+// sprites are drawn a byte at a time, with a mask of the rows they cover,
+// rather than pixel by pixel. Coordinates can be out of the screen.
+
+// What drawing does to the pixels: shapes are made of pixels on, sprites are
+// combined with the pixels they cover
+#define GFX_SET    0 // Pixels on, OR for sprites
+#define GFX_INVERT 1 // XOR
+#define GFX_CLEAR  2 // Pixels off, AND NOT for sprites
+#define GFX_AND    3 // Sprites only, pixels off where the sprite is off
+
+#define GFX_OR  GFX_SET
+#define GFX_XOR GFX_INVERT
+
+
+void
+gfx_set_pixel(const struct band* band, int16_t x, int16_t y, uint8_t op);
+
+void
+gfx_hline(const struct band* band, int16_t x, int16_t y, uint8_t width, uint8_t op);
+
+void
+gfx_vline(const struct band* band, int16_t x, int16_t y, uint8_t height, uint8_t op);
+
+// Bresenham line, both ends included
+void
+gfx_line(const struct band* band, int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t op);
+
+void
+gfx_rect(const struct band* band, int16_t x, int16_t y, uint8_t width, uint8_t height, uint8_t op);
+
+void
+gfx_fill_rect(const struct band* band, int16_t x, int16_t y, uint8_t width, uint8_t height, uint8_t op);
+
+void
+gfx_circle(const struct band* band, int16_t cx, int16_t cy, uint8_t radius, uint8_t op);
+
+void
+gfx_fill_circle(const struct band* band, int16_t cx, int16_t cy, uint8_t radius, uint8_t op);
+
+// Sprite in flash memory, in the same layout as the screen: (height + 7) / 8
+// pages of width bytes. Its top-left corner goes at (x, y), any row.
+void
+gfx_blit(const struct band* band, int16_t x, int16_t y,
+         const __flash uint8_t* sprite, uint8_t width, uint8_t height, uint8_t op);
+
+
+#endif /* GFX_H */
@@ -0,0 +1,131 @@
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+
+#include "line.h"
+#include "uart.h"
+
+
+#define LINE_INDEX_MASK (LINE_COUNT - 1)
+
+
+// Line arena. Slots [tail, head) are handed to the main program, slot head
+// is filled by the reception hook. Indices are free running, as in ring.h.
+static char line_data[LINE_COUNT][LINE_MAX_LENGTH + 1];
+static uint8_t line_length[LINE_COUNT];
+static uint8_t line_flags[LINE_COUNT];
+static volatile uint8_t line_head;
+static volatile uint8_t line_tail;
+static uint8_t line_held; // The main program holds slot tail
+
+// Slot being filled, only used by the reception hook
+static uint8_t line_fill_length;
+static uint8_t line_fill_flags;
+
+
+// Hands the slot being filled to the main program, returns 0 if there is no
+// free slot to go on with
+static uint8_t
+line_publish(uint8_t flags) {
+	if ((uint8_t)(line_head - line_tail) == LINE_COUNT - 1)
+		return 0;
+
+	uint8_t i = line_head & LINE_INDEX_MASK;
+	line_data[i][line_fill_length] = '\0';
+	line_length[i] = line_fill_length;
+	line_flags[i] = line_fill_flags | flags;
+	line_head += 1;
+
+	line_fill_length = 0;
+	line_fill_flags = 0;
+
+	// Only the slot being filled is left, ask the sender to pause while it
+	// still has room for what comes meanwhile
+	if ((uint8_t)(line_head - line_tail) == LINE_COUNT - 1)
+		uart_rx_throttle(1);
+
+	// Job done
+	return 1;
+}
+
+
+// Called from USART_RX_vect for each character
+static uint8_t
+line_rx_hook(char c) {
+	if (c == '\r')
+		return 1;
+
+	if (c == '\n') {
+		if (!line_publish(0)) {
+			// No room, the line is lost, the slot is reused
+			line_fill_length = 0;
+			line_fill_flags = LINE_DROPPED;
+		}
+		return 1;
+	}
+
+	// Slot full, hand it out as a part of the line
+	if ((line_fill_length == LINE_MAX_LENGTH) && !line_publish(LINE_PARTIAL)) {
+		line_fill_flags |= LINE_DROPPED;
+		return 1;
+	}
+
+	line_data[line_head & LINE_INDEX_MASK][line_fill_length++] = c;
+
+	// Job done
+	return 1;
+}
+
+
+void
+line_init(void) {
+	line_head = 0;
+	line_tail = 0;
+	line_held = 0;
+	line_fill_length = 0;
+	line_fill_flags = 0;
+
+	uart_set_rx_hook(line_rx_hook);
+}
+
+
+uint8_t
+line_try_receive(struct line* line) {
+	// Give the previous slot back to the reception hook, the sender can go on
+	if (line_held) {
+		line_held = 0;
+		line_tail += 1;
+		uart_rx_throttle(0);
+	}
+
+	if (line_head == line_tail)
+		return 0;
+
+	uint8_t i = line_tail & LINE_INDEX_MASK;
+	line->data = line_data[i];
+	line->length = line_length[i];
+	line->flags = line_flags[i];
+	line_held = 1;
+
+	// Job done
+	return 1;
+}
+
+
+void
+line_receive(struct line* line) {
+	while(!line_try_receive(line)) {
+		// Sleeps until the reception hook hands out a line. Interrupts are
+		// enabled right before sleep_cpu, so that the wake-up interrupt
+		// cannot be missed.
+		cli();
+		while(line_head == line_tail) {
+			sleep_enable();
+			sei();
+			sleep_cpu();
+			sleep_disable();
+			cli();
+		}
+		sei();
+	}
+}
@@ -0,0 +1,60 @@
+#ifndef LINE_H
+#define LINE_H
+
+#include <stdint.h>
+
+
+// --- Line reception ---------------------------------------------------------
+//
+// The USART_RX_vect handler, through the UART reception hook, stores incoming
+// characters straight into a slot of the line arena. On '\n', the slot is
+// handed to the main program as a (pointer, length) view, and the next slot
+// is filled. The main program only wakes up once per line, and reads the
+// characters where the interrupt handler wrote them. '\r' is ignored.
+//
+// A line longer than LINE_MAX_LENGTH is not cut silently: a full slot is
+// handed out with the LINE_PARTIAL flag, and the line goes on in the next
+// slot. When all the slots but the one being filled are held by the main
+// program, the sender is asked to pause, with the flow control set by
+// uart_set_flow_control, until a slot is released. If the characters keep
+// coming and the last slot fills up, they are dropped, and the next line
+// handed out has the LINE_DROPPED flag. Lines take all the incoming bytes,
+// except XON/XOFF.
+
+#ifndef LINE_MAX_LENGTH
+#define LINE_MAX_LENGTH 31
+#endif
+
+// Number of slots in the arena, a power of 2
+#ifndef LINE_COUNT
+#define LINE_COUNT 4
+#endif
+
+_Static_assert((LINE_COUNT & (LINE_COUNT - 1)) == 0, "LINE_COUNT must be a power of 2");
+_Static_assert(LINE_MAX_LENGTH < 255, "LINE_MAX_LENGTH must fit in a byte");
+
+#define LINE_PARTIAL 0x01 // The line goes on in the next view
+#define LINE_DROPPED 0x02 // Characters were lost before this view
+
+
+struct line {
+	const char* data; // NUL terminated, valid until the next line_receive call
+	uint8_t length;
+	uint8_t flags;    // LINE_PARTIAL, LINE_DROPPED
+};
+
+
+// Install the UART reception hook, uart_init must have been called first
+void
+line_init(void);
+
+// Releases the previous line, then returns 1 if a line was received
+uint8_t
+line_try_receive(struct line* line);
+
+// Releases the previous line, then sleeps until a line is received
+void
+line_receive(struct line* line);
+
+
+#endif /* LINE_H */
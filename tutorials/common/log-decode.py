@@ -0,0 +1,144 @@
+import re
+import sys
+import argparse
+
+
+LOG_SYNC = 0xa5
+LOG_MAX_ARGS = 8
+
+# printf conversion specification : flags, width, precision, length, conversion
+CONVERSION_RE = re.compile(r'%([-+ #0]*)(\d*)(\.\d+)?(hh|h|ll|l)?([diouxXcsp%])')
+
+
+def load_hex(path):
+    # Read an Intel HEX file as a dictionary, address to byte
+    memory = {}
+    base = 0
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line.startswith(':'):
+                continue
+            record = bytes.fromhex(line[1:])
+            count, address, kind, data = record[0], (record[1] << 8) | record[2], record[3], record[4:4 + record[0]]
+            if kind == 0x00:
+                for i, byte in enumerate(data):
+                    memory[base + address + i] = byte
+            elif kind == 0x02:
+                base = ((data[0] << 8) | data[1]) << 4
+            elif kind == 0x04:
+                base = ((data[0] << 8) | data[1]) << 16
+    return memory
+
+
+class Record:
+    def __init__(self, sizes, format):
+        self.sizes = sizes
+        self.format = format
+
+    def decode(self, payload):
+        # Split the payload according to the argument sizes
+        args = []
+        offset = 0
+        for size in self.sizes:
+            args.append(payload[offset:offset + size])
+            offset += size
+
+        # Replace each conversion with its argument, formatted by Python
+        arg_iter = iter(args)
+        def convert(match):
+            flags, width, precision, length, conversion = match.groups()
+            if conversion == '%':
+                return '%'
+            raw = next(arg_iter, None)
+            if raw is None:
+                return '<missing>'
+            value = int.from_bytes(raw, 'little', signed = conversion in 'dic')
+            if conversion == 's':
+                return f'<0x{value:04x}>'
+            if conversion == 'p':
+                return f'0x{value:04x}'
+            if conversion == 'c':
+                value &= 0xff
+            return f'%{flags}{width}{precision or ""}{conversion}' % value
+
+        return CONVERSION_RE.sub(convert, self.format)
+
+
+def find_record(memory, address):
+    # Parse and validate a log record, None if there is no record there
+    argc = memory.get(address)
+    if argc is None or argc > LOG_MAX_ARGS:
+        return None
+    sizes = [memory.get(address + 1 + i) for i in range(argc)]
+    if any(size not in (1, 2, 4, 8) for size in sizes):
+        return None
+
+    format = bytearray()
+    address += 1 + argc
+    while True:
+        byte = memory.get(address)
+        if byte is None:
+            return None
+        if byte == 0:
+            break
+        if byte < 0x20 and byte not in (0x09, 0x0a, 0x0d):
+            return None
+        format.append(byte)
+        address += 1
+
+    return Record(sizes, format.decode('ascii', errors = 'replace'))
+
+
+def decode_stream(memory, read, write):
+    # Frames are LOG_SYNC, record address, arguments. Anything else is text.
+    records = {}
+    while True:
+        byte = read(1)
+        if not byte:
+            return
+        if byte[0] != LOG_SYNC:
+            write(byte.decode('ascii', errors = 'replace'))
+            continue
+
+        header = read(2)
+        if len(header) < 2:
+            return
+        address = header[0] | (header[1] << 8)
+        if address not in records:
+            records[address] = find_record(memory, address)
+        record = records[address]
+        if record is None:
+            write(f'<bad log frame 0x{address:04x}>\n')
+            continue
+
+        payload = read(sum(record.sizes))
+        write(record.decode(payload) + '\n')
+
+
+def main():
+    # Command line arguments
+    parser = argparse.ArgumentParser(description = 'Decode the LOG frames sent by a firmware on the serial port')
+    parser.add_argument('--port', default = '/dev/ttyUSB0')
+    parser.add_argument('--baud', type = int, default = 9600)
+    parser.add_argument('--input', help = 'read a captured stream from a file instead of the serial port')
+    parser.add_argument('hex_path', help = 'the firmware, as uploaded')
+
+    args = parser.parse_args()
+
+    memory = load_hex(args.hex_path)
+    def write(text):
+        sys.stdout.write(text)
+        sys.stdout.flush()
+
+    if args.input:
+        with open(args.input, 'rb') as f:
+            decode_stream(memory, f.read, write)
+    else:
+        import serial
+        with serial.Serial(args.port, args.baud) as port:
+            decode_stream(memory, port.read, write)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,16 @@
+#include <avr/io.h>
+
+#include "log.h"
+#include "uart.h"
+
+
+#ifndef LOG_TEXT
+void
+log_emit(const __flash uint8_t* record, const uint8_t* args, uint8_t size) {
+	uint16_t id = (uint16_t)record;
+	uint8_t header[3] = { LOG_SYNC, id & 0xff, id >> 8 };
+
+	uart_write(header, sizeof(header));
+	uart_write(args, size);
+}
+#endif
@@ -0,0 +1,95 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <avr/io.h>
+#include <stdint.h>
+#include <string.h>
+
+
+// --- Deferred formatting logs -----------------------------------------------
+//
+// LOG(fmt, ...) works like printf, but the formatting is done on the host.
+// The format string stays in flash, in a record that also holds the size of
+// each argument. A call only sends
+//
+//   LOG_SYNC, record address (2 bytes, little endian), raw argument bytes
+//
+// on the UART, and log-decode.py rebuilds the text, reading the records from
+// the firmware's .hex file. Each record is printed as a line, formats should
+// not end with "\r\n".
+//
+// Arguments are integers, up to LOG_MAX_ARGS of them. %s is not supported,
+// as the string would have to be sent. LOG is not meant to be called from an
+// interrupt handler, as it might sleep until there is room in the UART
+// buffer.
+//
+// Building with -DLOG_TEXT makes LOG a plain fprintf_P on the UART, to compare
+// both approaches.
+
+#define LOG_SYNC 0xa5
+#define LOG_MAX_ARGS 8
+
+
+#ifdef LOG_TEXT
+
+#include <avr/pgmspace.h>
+#include <stdio.h>
+#include "uart.h"
+
+#define LOG(fmt, ...) \
+	fprintf_P(&uart_output, PSTR(fmt "\r\n"), ##__VA_ARGS__)
+
+#else
+
+// Sends a log record and its packed arguments
+void
+log_emit(const __flash uint8_t* record, const uint8_t* args, uint8_t size);
+
+
+// Argument count, from 0 to 8
+#define LOG_NARGS(...) LOG_NARGS_(_, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(_, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+
+// Apply m to each argument
+#define LOG_CONCAT(a, b) LOG_CONCAT_(a, b)
+#define LOG_CONCAT_(a, b) a##b
+#define LOG_EACH(m, ...) LOG_CONCAT(LOG_EACH_, LOG_NARGS(__VA_ARGS__))(m, ##__VA_ARGS__)
+#define LOG_EACH_0(m)
+#define LOG_EACH_1(m, a) m(a)
+#define LOG_EACH_2(m, a, ...) m(a) LOG_EACH_1(m, __VA_ARGS__)
+#define LOG_EACH_3(m, a, ...) m(a) LOG_EACH_2(m, __VA_ARGS__)
+#define LOG_EACH_4(m, a, ...) m(a) LOG_EACH_3(m, __VA_ARGS__)
+#define LOG_EACH_5(m, a, ...) m(a) LOG_EACH_4(m, __VA_ARGS__)
+#define LOG_EACH_6(m, a, ...) m(a) LOG_EACH_5(m, __VA_ARGS__)
+#define LOG_EACH_7(m, a, ...) m(a) LOG_EACH_6(m, __VA_ARGS__)
+#define LOG_EACH_8(m, a, ...) m(a) LOG_EACH_7(m, __VA_ARGS__)
+
+#define LOG_SIZE_ITEM(a) , sizeof(a)
+#define LOG_SIZE_SUM(a) + sizeof(a)
+#define LOG_PACK(a) {                                   \
+	__auto_type log_value = (a);                        \
+	memcpy(log_ptr, &log_value, sizeof(log_value));     \
+	log_ptr += sizeof(log_value);                       \
+}
+
+// The record is: argument count, size of each argument, format string
+#define LOG(fmt, ...) do {                                                    \
+	_Static_assert(LOG_NARGS(__VA_ARGS__) <= LOG_MAX_ARGS, "too many arguments"); \
+	static const __flash struct {                                             \
+		uint8_t sizes[LOG_NARGS(__VA_ARGS__) + 1];                            \
+		char format[sizeof(fmt)];                                             \
+	} log_record = {                                                          \
+		{ LOG_NARGS(__VA_ARGS__) LOG_EACH(LOG_SIZE_ITEM, ##__VA_ARGS__) },    \
+		fmt                                                                   \
+	};                                                                        \
+	uint8_t log_args[0 LOG_EACH(LOG_SIZE_SUM, ##__VA_ARGS__)];                \
+	uint8_t* log_ptr = log_args;                                              \
+	LOG_EACH(LOG_PACK, ##__VA_ARGS__)                                         \
+	(void)log_ptr;                                                            \
+	log_emit(log_record.sizes, log_args, sizeof(log_args));                   \
+} while(0)
+
+#endif /* LOG_TEXT */
+
+
+#endif /* LOG_H */
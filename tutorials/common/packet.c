@@ -0,0 +1,238 @@
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+#include <util/crc16.h>
+#include <string.h>
+
+#include "packet.h"
+#include "uart.h"
+
+
+// Two buffers: one filled by the reception hook, the other one holding the
+// last complete packet, until the main program releases it
+static uint8_t packet_buffers[2][PACKET_MAX_DECODED_SIZE];
+static volatile uint8_t packet_ready_index;
+static volatile uint8_t packet_ready_length; // 0 when no packet is ready
+static uint8_t packet_held;                  // The ready packet was handed out
+
+// COBS decoder state, only used by the reception hook
+static uint8_t packet_fill_index;
+static uint8_t packet_fill_length;
+static uint8_t packet_block_left;   // Bytes left in the current COBS block
+static uint8_t packet_zero_pending; // The current block ends with a zero
+static uint8_t packet_overflow;
+
+static volatile struct packet_errors packet_errors;
+
+
+static inline void
+packet_rx_reset() {
+	packet_fill_length = 0;
+	packet_block_left = 0;
+	packet_zero_pending = 0;
+	packet_overflow = 0;
+}
+
+
+static inline void
+packet_rx_append(uint8_t byte) {
+	if (packet_fill_length == PACKET_MAX_DECODED_SIZE) {
+		packet_overflow = 1;
+		return;
+	}
+
+	packet_buffers[packet_fill_index][packet_fill_length++] = byte;
+}
+
+
+// Called from USART_RX_vect for each byte, decodes COBS on the fly
+static uint8_t
+packet_rx_hook(char c) {
+	uint8_t byte = c;
+
+	// Delimiter, end of the packet
+	if (byte == 0) {
+		if (packet_overflow)
+			packet_errors.overflows += 1;
+		else if (packet_block_left != 0)
+			packet_errors.crc_errors += 1; // Truncated block
+		else if (packet_fill_length != 0) {
+			if (packet_ready_length == 0) {
+				packet_ready_index = packet_fill_index;
+				packet_ready_length = packet_fill_length;
+				packet_fill_index ^= 1;
+			}
+			else
+				packet_errors.dropped += 1;
+		}
+
+		packet_rx_reset();
+		return 1;
+	}
+
+	// Skip the rest of a packet too large
+	if (packet_overflow)
+		return 1;
+
+	// Code byte: the previous block is over, it might end with a zero
+	if (packet_block_left == 0) {
+		if (packet_zero_pending)
+			packet_rx_append(0);
+		packet_block_left = byte - 1;
+		packet_zero_pending = (byte != 0xff);
+		return 1;
+	}
+
+	// Data byte
+	packet_rx_append(byte);
+	packet_block_left -= 1;
+
+	// Job done
+	return 1;
+}
+
+
+void
+packet_init(void) {
+	packet_ready_length = 0;
+	packet_held = 0;
+	packet_fill_index = 0;
+	packet_rx_reset();
+	memset((void*)&packet_errors, 0, sizeof(packet_errors));
+
+	uart_set_rx_hook(packet_rx_hook);
+}
+
+
+uint8_t
+packet_try_receive(struct packet* packet) {
+	// Give the previous packet's buffer back to the reception hook
+	if (packet_held) {
+		packet_held = 0;
+		packet_ready_length = 0;
+	}
+
+	uint8_t length = packet_ready_length;
+	if (length == 0)
+		return 0;
+
+	// The CRC over the packet, CRC included, is zero if it is intact
+	const uint8_t* data = packet_buffers[packet_ready_index];
+	uint16_t crc = 0;
+	for(uint8_t i = 0; i < length; ++i)
+		crc = _crc_xmodem_update(crc, data[i]);
+
+	if ((length < 3) || (crc != 0)) {
+		cli();
+		packet_errors.crc_errors += 1; // The reception hook updates it too
+		sei();
+		packet_ready_length = 0;
+		return 0;
+	}
+
+	packet->type = data[0];
+	packet->length = length - 3;
+	packet->payload = data + 1;
+	packet_held = 1;
+
+	// Job done
+	return 1;
+}
+
+
+void
+packet_receive(struct packet* packet) {
+	while(!packet_try_receive(packet)) {
+		// Sleeps until the reception hook completes a packet. Interrupts are
+		// enabled right before sleep_cpu, so that the wake-up interrupt
+		// cannot be missed.
+		cli();
+		while(packet_ready_length == 0) {
+			sleep_enable();
+			sei();
+			sleep_cpu();
+			sleep_disable();
+			cli();
+		}
+		sei();
+	}
+}
+
+
+// --- Transmission -----------------------------------------------------------
+
+struct packet_encoder {
+	uint8_t* frame;
+	uint8_t code_index; // Where the code byte of the current block goes
+	uint8_t index;
+	uint8_t code;
+};
+
+
+static void
+packet_encode_byte(struct packet_encoder* encoder, uint8_t byte) {
+	if (byte != 0) {
+		encoder->frame[encoder->index++] = byte;
+		encoder->code += 1;
+		if (encoder->code != 0xff)
+			return;
+	}
+
+	// Close the block, either on a zero or after 254 non-zero bytes
+	encoder->frame[encoder->code_index] = encoder->code;
+	encoder->code_index = encoder->index++;
+	encoder->code = 1;
+}
+
+
+void
+packet_send(uint8_t type, const void* payload, uint8_t length) {
+	uint8_t frame[PACKET_MAX_ENCODED_SIZE];
+	struct packet_encoder encoder = { frame, 0, 1, 1 };
+
+	if (length > PACKET_MAX_PAYLOAD)
+		length = PACKET_MAX_PAYLOAD;
+
+	// Type and payload
+	uint16_t crc = _crc_xmodem_update(0, type);
+	packet_encode_byte(&encoder, type);
+
+	const uint8_t* ptr = payload;
+	for(uint8_t i = 0; i < length; ++i) {
+		crc = _crc_xmodem_update(crc, ptr[i]);
+		packet_encode_byte(&encoder, ptr[i]);
+	}
+
+	// CRC, most significant byte first
+	packet_encode_byte(&encoder, crc >> 8);
+	packet_encode_byte(&encoder, crc & 0xff);
+
+	// Close the last block, then the delimiter
+	frame[encoder.code_index] = encoder.code;
+	frame[encoder.index++] = 0;
+
+	uart_write(frame, encoder.index);
+}
+
+
+uint8_t
+packet_dispatch(const struct packet* packet,
+                const __flash struct packet_handler* handlers,
+                uint8_t handler_count) {
+	for(uint8_t i = 0; i < handler_count; ++i)
+		if (handlers[i].type == packet->type) {
+			handlers[i].handler(packet);
+			return 1;
+		}
+
+	return 0;
+}
+
+
+void
+packet_get_errors(struct packet_errors* errors) {
+	cli();
+	memcpy(errors, (const void*)&packet_errors, sizeof(packet_errors));
+	memset((void*)&packet_errors, 0, sizeof(packet_errors));
+	sei();
+}
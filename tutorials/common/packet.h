@@ -0,0 +1,82 @@
+#ifndef PACKET_H
+#define PACKET_H
+
+#include <avr/io.h>
+#include <stdint.h>
+
+
+// --- Binary packets over the UART -------------------------------------------
+//
+// A packet is a type byte, a payload of up to PACKET_MAX_PAYLOAD bytes, and a
+// CRC-16 of both (XMODEM: polynomial 0x1021, initial value 0, sent most
+// significant byte first). It travels COBS encoded, followed by a 0x00
+// delimiter: COBS replaces each 0x00 by the distance to the next one, so that
+// 0x00 only ever marks the end of a packet, and a receiver that lost track
+// resynchronizes on the next delimiter.
+//
+// Reception goes through the UART reception hook: the USART_RX_vect handler
+// decodes the COBS stream on the fly, and only packet_receive is woken up
+// when a whole packet is there. Packets take all the incoming bytes, so do not
+// mix them with text input, nor with XON/XOFF flow control.
+
+#ifndef PACKET_MAX_PAYLOAD
+#define PACKET_MAX_PAYLOAD 64
+#endif
+
+// Type, payload and CRC, before COBS encoding
+#define PACKET_MAX_DECODED_SIZE (PACKET_MAX_PAYLOAD + 3)
+
+// COBS adds one byte per 254 bytes, plus one, then comes the delimiter
+#define PACKET_MAX_ENCODED_SIZE (PACKET_MAX_DECODED_SIZE + PACKET_MAX_DECODED_SIZE / 254 + 2)
+
+_Static_assert(PACKET_MAX_DECODED_SIZE <= 255, "PACKET_MAX_PAYLOAD is too large");
+
+
+struct packet {
+	uint8_t type;
+	uint8_t length;         // Payload size
+	const uint8_t* payload; // Valid until the next packet_receive call
+};
+
+// Reception errors, cleared by packet_get_errors
+struct packet_errors {
+	uint16_t crc_errors;    // Packets with a wrong CRC, or too short
+	uint16_t overflows;     // Packets larger than PACKET_MAX_DECODED_SIZE
+	uint16_t dropped;       // Packets received before the previous one was released
+};
+
+// Handler for one packet type, see packet_dispatch
+struct packet_handler {
+	uint8_t type;
+	void (*handler)(const struct packet* packet);
+};
+
+
+// Install the UART reception hook, uart_init must have been called first
+void
+packet_init(void);
+
+// Releases the previous packet, then returns 1 if a valid packet was received
+uint8_t
+packet_try_receive(struct packet* packet);
+
+// Releases the previous packet, then sleeps until a valid packet is received
+void
+packet_receive(struct packet* packet);
+
+// Encodes and queues a packet, sleeps until there is room in the UART buffer
+void
+packet_send(uint8_t type, const void* payload, uint8_t length);
+
+// Calls the handler for the packet's type, returns 0 if there is none
+uint8_t
+packet_dispatch(const struct packet* packet,
+                const __flash struct packet_handler* handlers,
+                uint8_t handler_count);
+
+// Copy the reception error counters, then reset them
+void
+packet_get_errors(struct packet_errors* errors);
+
+
+#endif /* PACKET_H */
@@ -0,0 +1,126 @@
+import sys
+import time
+import argparse
+
+
+# Same layout as common/packet.h : type, payload, CRC-16 XMODEM, COBS encoded,
+# followed by a 0x00 delimiter
+MAX_PAYLOAD = 64
+
+
+def crc16(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte << 8
+        for i in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+        crc &= 0xffff
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code_index, code = 0, 1
+    for byte in data:
+        if byte != 0:
+            out.append(byte)
+            code += 1
+            if code != 0xff:
+                continue
+        out[code_index] = code
+        code_index, code = len(out), 1
+        out.append(0)
+    out[code_index] = code
+    return bytes(out)
+
+
+def cobs_decode(data):
+    # Returns None if the block lengths do not match the data
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code != 0xff and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def encode(type, payload = b''):
+    if len(payload) > MAX_PAYLOAD:
+        raise ValueError(f'payload larger than {MAX_PAYLOAD} bytes')
+    data = bytes([type]) + bytes(payload)
+    crc = crc16(data)
+    return cobs_encode(data + bytes([crc >> 8, crc & 0xff])) + b'\x00'
+
+
+def decode(frame):
+    # Frame without its delimiter, returns (type, payload) or None
+    data = cobs_decode(frame)
+    if data is None or len(data) < 3 or crc16(data) != 0:
+        return None
+    return data[0], data[1:-2]
+
+
+class Link:
+    # Sends and receives packets on a serial port, or anything with read and write
+    def __init__(self, port):
+        self.port = port
+        self.pending = bytearray()
+        self.errors = 0
+
+    def send(self, type, payload = b''):
+        self.port.write(encode(type, payload))
+
+    def receive(self, timeout):
+        # Returns (type, payload), or None after timeout seconds
+        deadline = time.monotonic() + timeout
+        while True:
+            while b'\x00' in self.pending:
+                frame, _, self.pending = self.pending.partition(b'\x00')
+                if not frame:
+                    continue
+                packet = decode(bytes(frame))
+                if packet is None:
+                    self.errors += 1
+                    continue
+                return packet
+            if time.monotonic() >= deadline:
+                return None
+            self.pending += self.port.read(max(1, self.port.in_waiting))
+
+
+def main():
+    # Command line arguments
+    parser = argparse.ArgumentParser(description = 'Send a packet to the device, then print the packets received')
+    parser.add_argument('--port', default = '/dev/ttyUSB0')
+    parser.add_argument('--baud', type = int, default = 9600)
+    parser.add_argument('--timeout', type = float, default = 1., help = 'seconds to wait for answers')
+    parser.add_argument('type', type = lambda s: int(s, 0), help = 'packet type, ie. 0x01')
+    parser.add_argument('payload', nargs = '?', default = '', help = 'payload, as hexadecimal')
+
+    args = parser.parse_args()
+
+    import serial
+    with serial.Serial(args.port, args.baud, timeout = .05) as port:
+        # Opening the port resets the Arduino
+        time.sleep(2.)
+        port.reset_input_buffer()
+
+        link = Link(port)
+        link.send(args.type, bytes.fromhex(args.payload))
+        while True:
+            packet = link.receive(args.timeout)
+            if packet is None:
+                break
+            print(f'type 0x{packet[0]:02x} : {packet[1].hex(" ")}')
+
+    if link.errors:
+        print(f'{link.errors} corrupted packet(s)', file = sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
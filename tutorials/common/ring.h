@@ -0,0 +1,142 @@
+#ifndef RING_H
+#define RING_H
+
+#include <stdint.h>
+#include <string.h>
+
+
+// --- Lock-free single producer, single consumer ring buffer -----------------
+//
+// RING_DEFINE(name, type, size) declares 'struct name' and its functions,
+// name_push, name_pop, etc. One side, ie. an interrupt handler, only pushes
+// while the other side only pops, so that no interrupt masking is needed.
+//
+// The head and tail indices are free running 8 bits counters: the element
+// count is head - tail, wrapping around is done with a mask, and all the
+// slots can be used. Thus the size has to be a power of two, up to 128.
+//
+// Indices are read and written with a single instruction on a 8 bits MCU.
+// The compiler barriers make sure that an element is written before the head
+// moves past it, and read before the tail moves past it.
+
+#define RING_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+#define RING_DEFINE(name, type, size)                                         \
+_Static_assert(((size) >= 2) && ((size) <= 128) && (((size) & ((size) - 1)) == 0), \
+	#name " size must be a power of two, from 2 to 128");                     \
+                                                                              \
+struct name {                                                                 \
+	volatile uint8_t head; /* Only written by the producer */                 \
+	volatile uint8_t tail; /* Only written by the consumer */                 \
+	type data[size];                                                          \
+};                                                                            \
+                                                                              \
+static inline void                                                            \
+name##_init(struct name* ring) {                                              \
+	ring->head = 0;                                                           \
+	ring->tail = 0;                                                           \
+}                                                                             \
+                                                                              \
+static inline uint8_t                                                         \
+name##_count(const struct name* ring) {                                       \
+	return (uint8_t)(ring->head - ring->tail);                                \
+}                                                                             \
+                                                                              \
+static inline uint8_t                                                         \
+name##_room(const struct name* ring) {                                        \
+	return (size) - name##_count(ring);                                       \
+}                                                                             \
+                                                                              \
+static inline uint8_t                                                         \
+name##_is_empty(const struct name* ring) {                                    \
+	return ring->head == ring->tail;                                          \
+}                                                                             \
+                                                                              \
+static inline uint8_t                                                         \
+name##_is_full(const struct name* ring) {                                     \
+	return name##_count(ring) == (size);                                      \
+}                                                                             \
+                                                                              \
+/* Producer side, returns 0 if the ring is full */                            \
+static inline uint8_t                                                         \
+name##_push(struct name* ring, type value) {                                  \
+	uint8_t head = ring->head;                                                \
+	if ((uint8_t)(head - ring->tail) == (size))                               \
+		return 0;                                                             \
+	ring->data[head & ((size) - 1)] = value;                                  \
+	RING_BARRIER();                                                           \
+	ring->head = head + 1;                                                    \
+	return 1;                                                                 \
+}                                                                             \
+                                                                              \
+/* Consumer side, returns 0 if the ring is empty */                           \
+static inline uint8_t                                                         \
+name##_pop(struct name* ring, type* value) {                                  \
+	uint8_t tail = ring->tail;                                                \
+	if (ring->head == tail)                                                   \
+		return 0;                                                             \
+	RING_BARRIER();                                                           \
+	*value = ring->data[tail & ((size) - 1)];                                 \
+	RING_BARRIER();                                                           \
+	ring->tail = tail + 1;                                                    \
+	return 1;                                                                 \
+}                                                                             \
+                                                                              \
+/* Consumer side, oldest element or NULL, stays in the ring until popped */   \
+static inline type*                                                           \
+name##_peek(struct name* ring) {                                              \
+	uint8_t tail = ring->tail;                                                \
+	if (ring->head == tail)                                                   \
+		return 0;                                                             \
+	RING_BARRIER();                                                           \
+	return &ring->data[tail & ((size) - 1)];                                  \
+}                                                                             \
+                                                                              \
+/* Consumer side, drops the oldest element, ring must not be empty */         \
+static inline void                                                            \
+name##_skip(struct name* ring) {                                              \
+	RING_BARRIER();                                                           \
+	ring->tail = ring->tail + 1;                                              \
+}                                                                             \
+                                                                              \
+/* Producer side, copies as many elements as there is room for, with at */   \
+/* most two memcpy calls, and moves the head once. Returns the count. */      \
+static inline uint8_t                                                         \
+name##_push_n(struct name* ring, const type* values, uint8_t count) {         \
+	uint8_t head = ring->head;                                                \
+	uint8_t room = (size) - (uint8_t)(head - ring->tail);                     \
+	if (count > room)                                                         \
+		count = room;                                                         \
+	uint8_t start = head & ((size) - 1);                                      \
+	uint8_t first = (size) - start;                                           \
+	if (first > count)                                                        \
+		first = count;                                                        \
+	memcpy(&ring->data[start], values, first * sizeof(type));                 \
+	memcpy(&ring->data[0], values + first, (count - first) * sizeof(type));   \
+	RING_BARRIER();                                                           \
+	ring->head = head + count;                                                \
+	return count;                                                             \
+}                                                                             \
+                                                                              \
+/* Consumer side, copies as many elements as available, up to count, with */ \
+/* at most two memcpy calls, and moves the tail once. Returns the count. */   \
+static inline uint8_t                                                         \
+name##_pop_n(struct name* ring, type* values, uint8_t count) {                \
+	uint8_t tail = ring->tail;                                                \
+	uint8_t available = (uint8_t)(ring->head - tail);                         \
+	if (count > available)                                                    \
+		count = available;                                                    \
+	uint8_t start = tail & ((size) - 1);                                      \
+	uint8_t first = (size) - start;                                           \
+	if (first > count)                                                        \
+		first = count;                                                        \
+	RING_BARRIER();                                                           \
+	memcpy(values, &ring->data[start], first * sizeof(type));                 \
+	memcpy(values + first, &ring->data[0], (count - first) * sizeof(type));   \
+	RING_BARRIER();                                                           \
+	ring->tail = tail + count;                                                \
+	return count;                                                             \
+}
+
+
+#endif /* RING_H */
@@ -0,0 +1,88 @@
+#include <avr/io.h>
+#include <string.h>
+
+#include "rle.h"
+#include "ssd1306.h"
+
+
+_Static_assert(RLE_CHUNK_SIZE <= 255, "RLE_CHUNK_SIZE should fit a byte");
+
+
+// One chunk is decoded while the other is sent
+static uint8_t rle_chunks[2][RLE_CHUNK_SIZE];
+
+
+void
+rle_init(struct rle_decoder* decoder, const __flash uint8_t* data) {
+	decoder->data = data;
+	decoder->count = 0;
+}
+
+
+void
+rle_decode(struct rle_decoder* decoder, uint8_t* out, uint16_t size) {
+	while(size != 0) {
+		// Next run
+		if (decoder->count == 0) {
+			uint8_t control = *decoder->data++;
+			decoder->repeat = control & 0x80;
+			if (decoder->repeat) {
+				decoder->count = (control & 0x7f) + 2;
+				decoder->value = *decoder->data++;
+			}
+			else
+				decoder->count = control + 1;
+		}
+
+		// As much of it as needed
+		uint8_t count = (size < decoder->count) ? size : decoder->count;
+		if (decoder->repeat)
+			memset(out, decoder->value, count);
+		else
+			for(uint8_t i = 0; i < count; ++i)
+				out[i] = *decoder->data++;
+
+		out += count;
+		size -= count;
+		decoder->count -= count;
+	}
+}
+
+
+uint8_t
+rle_upload_bitmap(const __flash uint8_t* data) {
+	struct rle_decoder decoder;
+	rle_init(&decoder, data);
+
+	// The whole screen, in as many windows as the RAM pages wrap around.
+	// Bytes left in the current window.
+	uint16_t window_left = ssd1306_set_screen_window(0, SSD1306_WIDTH - 1, 0, SSD1306_PAGE_COUNT - 1) * SSD1306_WIDTH;
+	if (window_left == 0)
+		return 0;
+
+	uint8_t ret = 1;
+	uint8_t index = 0;
+	for(uint16_t left = SSD1306_BUFFER_SIZE; left != 0; index ^= 1) {
+		if (window_left == 0) {
+			uint8_t page = (SSD1306_BUFFER_SIZE - left) / SSD1306_WIDTH;
+			window_left = ssd1306_set_screen_window(0, SSD1306_WIDTH - 1, page, SSD1306_PAGE_COUNT - 1) * SSD1306_WIDTH;
+			if (window_left == 0) {
+				ssd1306_wait();
+				return 0;
+			}
+		}
+
+		// A chunk does not straddle two windows
+		uint8_t size = (window_left < RLE_CHUNK_SIZE) ? window_left : RLE_CHUNK_SIZE;
+		rle_decode(&decoder, rle_chunks[index], size);
+
+		// Waits for the previous chunk, which was decoded in the other buffer
+		ret &= ssd1306_start_data(rle_chunks[index], size);
+		left -= size;
+		window_left -= size;
+	}
+	ret &= ssd1306_wait();
+
+	// Job done
+	return ret;
+}
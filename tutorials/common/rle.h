@@ -0,0 +1,45 @@
+#ifndef RLE_H
+#define RLE_H
+
+#include <stdint.h>
+
+
+// --- Run-length encoded bitmaps ---------------------------------------------
+//
+// Bitmaps in the SSD1306 page layout, as bitmap-to-code.py --rle writes them.
+// The stream is a list of runs, each starting with a control byte
+//   0lllllll : l + 1 bytes follow, copied as they are
+//   1rrrrrrr : the next byte is repeated r + 2 times
+// There is no end marker, the decoder is told how many bytes to produce.
+//
+// The decoder works a chunk at a time, so that a bitmap can be decoded
+// straight into the data stream to the screen, without a copy in RAM.
+
+// Bytes decoded at once by rle_upload_bitmap, twice that in RAM
+#ifndef RLE_CHUNK_SIZE
+#define RLE_CHUNK_SIZE 64
+#endif
+
+
+struct rle_decoder {
+	const __flash uint8_t* data; // Next byte of the stream
+	uint8_t count;               // Bytes left in the current run
+	uint8_t repeat;              // 1 if the run repeats value
+	uint8_t value;
+};
+
+
+void
+rle_init(struct rle_decoder* decoder, const __flash uint8_t* data);
+
+// Decodes the next size bytes
+void
+rle_decode(struct rle_decoder* decoder, uint8_t* out, uint16_t size);
+
+// As ssd1306_upload_bitmap, for a run-length encoded bitmap. Each chunk is
+// sent while the next one is decoded. Returns 0 on failure.
+uint8_t
+rle_upload_bitmap(const __flash uint8_t* data);
+
+
+#endif /* RLE_H */
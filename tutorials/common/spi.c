@@ -0,0 +1,111 @@
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+#include <stddef.h>
+
+#include "spi.h"
+
+
+// Transfer in progress, NULL when idle
+static struct spi_transfer* volatile spi_current;
+static uint16_t spi_write_index;
+
+
+static uint8_t
+spi_next_write_byte(const struct spi_transfer* transfer) {
+	uint16_t i = spi_write_index++;
+	if (transfer->flags & SPI_WRITE_FILL)
+		return transfer->write_buffer.ram[0];
+	if (transfer->flags & SPI_WRITE_FLASH)
+		return transfer->write_buffer.flash[i];
+	return transfer->write_buffer.ram[i];
+}
+
+
+// Close the transfer in progress
+static void
+spi_finish() {
+	struct spi_transfer* transfer = spi_current;
+	spi_current = NULL;
+	transfer->status = SPI_OK;
+	if (transfer->callback)
+		transfer->callback(transfer);
+}
+
+
+// The previous byte is out, send the next one
+ISR(SPI_STC_vect) {
+	struct spi_transfer* transfer = spi_current;
+	if (spi_write_index < transfer->write_length)
+		SPDR = spi_next_write_byte(transfer);
+	else
+		spi_finish();
+}
+
+
+void
+spi_init(void) {
+	spi_current = NULL;
+
+	// SCK, MOSI and SS as outputs
+	DDRB |= _BV(DDB5) | _BV(DDB3) | _BV(DDB2);
+
+	// Enable, master, interrupt, mode 0, F_CPU / 2
+	SPCR = _BV(SPE) | _BV(MSTR) | _BV(SPIE);
+	SPSR = _BV(SPI2X);
+}
+
+
+uint8_t
+spi_submit(struct spi_transfer* transfer) {
+	uint8_t ret = 0;
+	uint8_t sreg = SREG;
+	cli();
+
+	if (spi_current == NULL) {
+		ret = 1;
+		spi_current = transfer;
+		spi_write_index = 0;
+		transfer->status = SPI_PENDING;
+
+		// The first byte starts the ball rolling
+		if (transfer->write_length != 0)
+			SPDR = spi_next_write_byte(transfer);
+		else
+			spi_finish();
+	}
+
+	SREG = sreg;
+
+	// Job done
+	return ret;
+}
+
+
+uint8_t
+spi_wait(struct spi_transfer* transfer) {
+	// Sleeps until the transfer is over. Interrupts are enabled right before
+	// sleep_cpu, so that the wake-up interrupt cannot be missed.
+	cli();
+	while(transfer->status == SPI_PENDING) {
+		sleep_enable();
+		sei();
+		sleep_cpu();
+		sleep_disable();
+		cli();
+	}
+	sei();
+
+	// Job done
+	return transfer->status;
+}
+
+
+uint8_t
+spi_transfer(struct spi_transfer* transfer) {
+	// Sleeps until the previous transfer is over
+	while(!spi_submit(transfer))
+		sleep_mode();
+
+	return spi_wait(transfer);
+}
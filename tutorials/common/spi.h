@@ -0,0 +1,62 @@
+#ifndef SPI_H
+#define SPI_H
+
+#include <avr/io.h>
+#include <stdint.h>
+
+
+// --- Interrupt-driven SPI master --------------------------------------------
+//
+// Write only, for displays and the like. A transfer is started with
+// spi_submit, and the SPI_STC_vect interrupt handler sends the next byte each
+// time the previous one is out. One transfer at a time, chip select is left
+// to the caller, ie. in the callback.
+//
+// SCK is pin 5 of PORTB, MOSI pin 3. Pin 2 (SS) is set as an output, as the
+// SPI would switch to slave mode if it was an input driven low, it can be
+// used as chip select.
+
+// Where the bytes of the write buffer are taken from, as with twi.h
+#define SPI_WRITE_RAM   0x00 // write_buffer.ram points to SRAM
+#define SPI_WRITE_FLASH 0x01 // write_buffer.flash points to flash memory
+#define SPI_WRITE_FILL  0x02 // write_buffer.ram[0] sent write_length times
+
+// Transfer status
+#define SPI_OK      0x00
+#define SPI_PENDING 0x01
+
+
+struct spi_transfer {
+	uint8_t flags;                   // One of the SPI_WRITE_* flags
+	union {
+		const uint8_t* ram;
+		const __flash uint8_t* flash;
+	} write_buffer;
+	uint16_t write_length;
+
+	// Called from the SPI interrupt once the last byte is out, can be NULL
+	void (*callback)(struct spi_transfer* transfer);
+
+	volatile uint8_t status;         // SPI_OK or SPI_PENDING
+};
+
+
+// Master, mode 0, most significant bit first, at F_CPU / 2
+void
+spi_init(void);
+
+// Starts a transfer, returns 0 if another one is in progress. The transfer
+// must stay alive until its status is not SPI_PENDING anymore.
+uint8_t
+spi_submit(struct spi_transfer* transfer);
+
+// Sleeps until the transfer is over, returns its status
+uint8_t
+spi_wait(struct spi_transfer* transfer);
+
+// Starts a transfer and sleeps until it is over, returns its status
+uint8_t
+spi_transfer(struct spi_transfer* transfer);
+
+
+#endif /* SPI_H */
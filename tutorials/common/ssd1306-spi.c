@@ -0,0 +1,75 @@
+#include <avr/io.h>
+#include <util/delay.h>
+
+#include "ssd1306.h"
+#include "ssd1306-transport.h"
+#include "spi.h"
+
+
+_Static_assert((SSD1306_SOURCE_FLASH == SPI_WRITE_FLASH) && (SSD1306_SOURCE_FILL == SPI_WRITE_FILL),
+	"SSD1306_SOURCE_* and SPI_WRITE_* should match");
+
+
+// 4-wire SPI modules: D/C low for commands, high for data, chip select active
+// low, reset active low
+#define SSD1306_SPI_DDR     DDRB
+#define SSD1306_SPI_PORT    PORTB
+#define SSD1306_SPI_RES_BIT PORTB0 // Pin 8
+#define SSD1306_SPI_DC_BIT  PORTB1 // Pin 9
+#define SSD1306_SPI_CS_BIT  PORTB2 // Pin 10
+
+
+static struct spi_transfer ssd1306_spi_transfer;
+
+
+// Called from the SPI interrupt, release the chip
+static void
+ssd1306_spi_done(struct spi_transfer* transfer) {
+	SSD1306_SPI_PORT |= _BV(SSD1306_SPI_CS_BIT);
+}
+
+
+void
+ssd1306_transport_init(void) {
+	// Control pins as outputs, chip not selected, in reset
+	SSD1306_SPI_DDR |= _BV(SSD1306_SPI_RES_BIT) | _BV(SSD1306_SPI_DC_BIT) | _BV(SSD1306_SPI_CS_BIT);
+	SSD1306_SPI_PORT |= _BV(SSD1306_SPI_CS_BIT);
+	SSD1306_SPI_PORT &= ~_BV(SSD1306_SPI_RES_BIT);
+
+	spi_init();
+
+	// Reset pulse, at least 3 usec
+	_delay_us(10);
+	SSD1306_SPI_PORT |= _BV(SSD1306_SPI_RES_BIT);
+	_delay_us(10);
+}
+
+
+void
+ssd1306_transport_start(uint8_t flags, union ssd1306_source source, uint16_t length) {
+	struct spi_transfer* transfer = &ssd1306_spi_transfer;
+	spi_wait(transfer);
+
+	// D/C can only change while the chip is not selected
+	if (flags & SSD1306_SEND_DATA)
+		SSD1306_SPI_PORT |= _BV(SSD1306_SPI_DC_BIT);
+	else
+		SSD1306_SPI_PORT &= ~_BV(SSD1306_SPI_DC_BIT);
+	SSD1306_SPI_PORT &= ~_BV(SSD1306_SPI_CS_BIT);
+
+	transfer->flags = flags & SSD1306_SOURCE_MASK;
+	if (flags & SSD1306_SOURCE_FLASH)
+		transfer->write_buffer.flash = source.flash;
+	else
+		transfer->write_buffer.ram = source.ram;
+	transfer->write_length = length;
+	transfer->callback = ssd1306_spi_done;
+
+	spi_submit(transfer);
+}
+
+
+uint8_t
+ssd1306_transport_wait(void) {
+	return spi_wait(&ssd1306_spi_transfer) == SPI_OK;
+}
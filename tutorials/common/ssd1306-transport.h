@@ -0,0 +1,47 @@
+#ifndef SSD1306_TRANSPORT_H
+#define SSD1306_TRANSPORT_H
+
+#include <avr/io.h>
+#include <stdint.h>
+
+
+// --- SSD1306 transport ------------------------------------------------------
+//
+// How ssd1306.c talks to the controller. There is one implementation per bus,
+// ssd1306-twi.c and ssd1306-spi.c, picked by linking one or the other. Both
+// send a list of command bytes, or of data bytes, and handle one transfer at
+// a time.
+
+// What the bytes are
+#define SSD1306_SEND_COMMANDS 0x00
+#define SSD1306_SEND_DATA     0x80
+
+// Where the bytes are taken from, same values as TWI_WRITE_* and SPI_WRITE_*
+#define SSD1306_SOURCE_RAM    0x00 // source.ram points to SRAM
+#define SSD1306_SOURCE_FLASH  0x01 // source.flash points to flash memory
+#define SSD1306_SOURCE_FILL   0x02 // source.ram[0] sent length times
+#define SSD1306_SOURCE_MASK   0x03
+
+
+union ssd1306_source {
+	const uint8_t* ram;
+	const __flash uint8_t* flash;
+};
+
+
+// Setup the bus and the control pins
+void
+ssd1306_transport_init(void);
+
+// Sleeps until the previous transfer is over, then starts sending, and
+// returns right away. The bytes must stay untouched until the transfer is
+// over.
+void
+ssd1306_transport_start(uint8_t flags, union ssd1306_source source, uint16_t length);
+
+// Sleeps until the transfer is over, returns 1 if it went well
+uint8_t
+ssd1306_transport_wait(void);
+
+
+#endif /* SSD1306_TRANSPORT_H */
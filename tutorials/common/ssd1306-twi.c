@@ -0,0 +1,56 @@
+#include <avr/io.h>
+#include <avr/sleep.h>
+
+#include "ssd1306.h"
+#include "ssd1306-transport.h"
+#include "twi.h"
+
+
+_Static_assert((SSD1306_SOURCE_FLASH == TWI_WRITE_FLASH) && (SSD1306_SOURCE_FILL == TWI_WRITE_FILL),
+	"SSD1306_SOURCE_* and TWI_WRITE_* should match");
+
+
+// Clock frequency for I2C protocol
+#ifndef SSD1306_F_SCL
+#define SSD1306_F_SCL 100000UL
+#endif
+
+
+// The control byte tells commands from data
+static struct twi_transaction ssd1306_twi_transaction;
+
+
+void
+ssd1306_transport_init(void) {
+	twi_init(TWI_BITRATE(SSD1306_F_SCL));
+}
+
+
+void
+ssd1306_transport_start(uint8_t flags, union ssd1306_source source, uint16_t length) {
+	struct twi_transaction* transaction = &ssd1306_twi_transaction;
+	twi_wait(transaction);
+
+	transaction->address = SSD1306_ADDRESS;
+	transaction->flags = flags & SSD1306_SOURCE_MASK;
+	transaction->header_length = 1;
+	transaction->header[0] = (flags & SSD1306_SEND_DATA) ? SSD1306_DATA_STREAM : SSD1306_COMMAND_STREAM;
+	if (flags & SSD1306_SOURCE_FLASH)
+		transaction->write_buffer.flash = source.flash;
+	else
+		transaction->write_buffer.ram = source.ram;
+	transaction->write_length = length;
+	transaction->read_buffer = 0;
+	transaction->read_length = 0;
+	transaction->callback = 0;
+
+	// Sleeps until there is room in the queue
+	while(!twi_submit(transaction))
+		sleep_mode();
+}
+
+
+uint8_t
+ssd1306_transport_wait(void) {
+	return twi_wait(&ssd1306_twi_transaction) == TWI_OK;
+}
@@ -0,0 +1,455 @@
+#include <avr/io.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ssd1306.h"
+#include "ssd1306-transport.h"
+
+
+// Startup sequence, sent as a single command stream
+static const __flash uint8_t
+SSD1306_init_sequence[] = {
+	// 0xAE = Set Display OFF
+	SSD1306_DISPLAY_OFF,
+	// 0xA8
+	SSD1306_SET_MUX_RATIO, SSD1306_HEIGHT - 1,
+	// 0x20 = Set Memory Addressing Mode
+	// -----------------------------------
+	// 0x00 - Horizontal Addressing Mode
+	// 0x01 - Vertical Addressing Mode
+	// 0x02 - Page Addressing Mode (RESET)
+	SSD1306_MEMORY_ADDR_MODE, 0x00,
+	// 0x21 = Set Column Address
+	SSD1306_SET_COLUMN_ADDR, SSD1306_COLUMN_OFFSET, SSD1306_COLUMN_OFFSET + SSD1306_WIDTH - 1,
+	// 0x22 = Set Page Address
+	SSD1306_SET_PAGE_ADDR, 0, SSD1306_PAGE_COUNT - 1,
+	// 0x40
+	SSD1306_SET_START_LINE,
+	// 0xD3
+	SSD1306_DISPLAY_OFFSET, 0x00,
+	// 0xA3, the reset area is 64 rows whatever the multiplex ratio
+	SSD1306_SET_VERTICAL_SCROLL_AREA, 0, SSD1306_HEIGHT,
+	// 0xA0 / remap 0xA1
+	SSD1306_SEG_REMAP_OP,
+	// 0xC0 / remap 0xC8
+	SSD1306_COM_SCAN_DIR_OP,
+	// 0xDA
+	SSD1306_COM_PIN_CONF, SSD1306_COM_PINS,
+	// 0x81
+	SSD1306_SET_CONTRAST, 0x50,
+	// 0xA4
+	SSD1306_DIS_ENT_DISP_ON,
+	// 0xA6
+	SSD1306_DIS_NORMAL,
+	// 0xD5
+	SSD1306_SET_OSC_FREQ, 0x80,
+	// 0xD9, 1st Period = higher value less blinking
+	SSD1306_SET_PRECHARGE, 0xc2,
+	// Set V COMH Deselect, reset value 0x22 = 0,77xUcc
+	SSD1306_VCOM_DESELECT, 0x20,
+	// 0x8D
+	SSD1306_SET_CHAR_REG, 0x14,
+	// Deactivate scrolling
+	SSD1306_DEACT_SCROLL,
+	// 0xAF = Set Display ON
+	SSD1306_DISPLAY_ON
+};
+
+
+// Commands waiting to be sent as a single command stream
+static uint8_t ssd1306_queue[SSD1306_COMMAND_QUEUE_SIZE];
+static uint8_t ssd1306_queue_length;
+static uint8_t ssd1306_batch_depth;
+static uint8_t ssd1306_batch_failed;
+
+// Set while data started with ssd1306_start_data may be on the way
+static uint8_t ssd1306_data_pending;
+
+// Where the controller shows its RAM, as far as the driver knows
+static uint8_t ssd1306_start_line;
+static uint8_t ssd1306_vertical_offset;
+static uint8_t ssd1306_scroll_area_rows;
+static uint8_t ssd1306_scroll_pages;    // One bit per RAM page scrolled
+static uint8_t ssd1306_scroll_vertical; // 1 for a diagonal scroll
+static uint8_t ssd1306_scroll_active;
+static uint8_t ssd1306_stale_pages;
+
+
+// Sends and sleeps until it is over, pending data included
+static uint8_t
+ssd1306_send(uint8_t flags, union ssd1306_source source, uint16_t length) {
+	uint8_t ret = ssd1306_wait();
+	ssd1306_transport_start(flags, source, length);
+	return ssd1306_transport_wait() && ret;
+}
+
+
+// Send the queued commands, if any, as a single command stream
+static uint8_t
+ssd1306_commit() {
+	if (ssd1306_queue_length == 0)
+		return 1;
+
+	uint8_t ret = ssd1306_send(
+		SSD1306_SEND_COMMANDS | SSD1306_SOURCE_RAM,
+		(union ssd1306_source){ .ram = ssd1306_queue },
+		ssd1306_queue_length);
+	ssd1306_queue_length = 0;
+	if (!ret)
+		ssd1306_batch_failed = 1;
+
+	// Job done
+	return ret;
+}
+
+
+uint8_t
+ssd1306_send_commands(const uint8_t* commands, uint8_t command_count) {
+	// Make room in the queue
+	uint8_t ret = 1;
+	if (ssd1306_queue_length + command_count > SSD1306_COMMAND_QUEUE_SIZE)
+		ret = ssd1306_commit();
+
+	memcpy(ssd1306_queue + ssd1306_queue_length, commands, command_count);
+	ssd1306_queue_length += command_count;
+
+	// Outside of a batch, send right away
+	if (ssd1306_batch_depth == 0)
+		ret &= ssd1306_commit();
+
+	return ret;
+}
+
+
+// Send a single command
+static uint8_t
+ssd1306_send_command(uint8_t command) {
+	return ssd1306_send_commands(&command, 1);
+}
+
+
+void
+ssd1306_begin_batch(void) {
+	if (ssd1306_batch_depth++ == 0)
+		ssd1306_batch_failed = 0;
+}
+
+
+uint8_t
+ssd1306_end_batch(void) {
+	if (--ssd1306_batch_depth != 0)
+		return 1;
+
+	ssd1306_commit();
+	return !ssd1306_batch_failed;
+}
+
+
+uint8_t
+ssd1306_init(void) {
+	ssd1306_queue_length = 0;
+	ssd1306_batch_depth = 0;
+	ssd1306_data_pending = 0;
+	ssd1306_start_line = 0;
+	ssd1306_vertical_offset = 0;
+	ssd1306_scroll_area_rows = SSD1306_HEIGHT;
+	ssd1306_scroll_pages = 0;
+	ssd1306_scroll_active = 0;
+	ssd1306_stale_pages = 0;
+	ssd1306_transport_init();
+
+	// Send the startup sequence straight from the flash memory, sleeps
+	// meanwhile
+	return ssd1306_send(
+		SSD1306_SEND_COMMANDS | SSD1306_SOURCE_FLASH,
+		(union ssd1306_source){ .flash = SSD1306_init_sequence },
+		sizeof(SSD1306_init_sequence));
+}
+
+
+uint8_t
+ssd1306_clear(void) {
+	// The whole screen, in as many windows as the RAM pages wrap around.
+	// Queued commands go first, then zeros as a data stream.
+	static const uint8_t zero = 0x00;
+	uint8_t page_count;
+	for(uint8_t page = 0; page < SSD1306_PAGE_COUNT; page += page_count) {
+		page_count = ssd1306_set_screen_window(0, SSD1306_WIDTH - 1, page, SSD1306_PAGE_COUNT - 1);
+		if (!page_count || !ssd1306_commit())
+			return 0;
+
+		if (!ssd1306_send(
+			SSD1306_SEND_DATA | SSD1306_SOURCE_FILL,
+			(union ssd1306_source){ .ram = &zero },
+			page_count * SSD1306_WIDTH))
+			return 0;
+	}
+
+	// Job done
+	return 1;
+}
+
+
+uint8_t
+ssd1306_upload_bitmap(const __flash uint8_t* bitmap) {
+	// The whole screen, in as many windows as the RAM pages wrap around.
+	// Queued commands go first, then the bitmap data as a stream, straight
+	// from the flash memory.
+	uint8_t page_count;
+	for(uint8_t page = 0; page < SSD1306_PAGE_COUNT; page += page_count) {
+		page_count = ssd1306_set_screen_window(0, SSD1306_WIDTH - 1, page, SSD1306_PAGE_COUNT - 1);
+		if (!page_count || !ssd1306_commit())
+			return 0;
+
+		if (!ssd1306_send(
+			SSD1306_SEND_DATA | SSD1306_SOURCE_FLASH,
+			(union ssd1306_source){ .flash = bitmap + page * SSD1306_WIDTH },
+			page_count * SSD1306_WIDTH))
+			return 0;
+	}
+
+	// Job done
+	return 1;
+}
+
+
+uint8_t
+ssd1306_set_window(uint8_t first_column, uint8_t last_column,
+                   uint8_t first_page, uint8_t last_page) {
+	if (ssd1306_scroll_active)
+		return 0;
+
+	uint8_t commands[6] = {
+		SSD1306_SET_COLUMN_ADDR, SSD1306_COLUMN_OFFSET + first_column, SSD1306_COLUMN_OFFSET + last_column,
+		SSD1306_SET_PAGE_ADDR, first_page, last_page
+	};
+
+	return ssd1306_send_commands(commands, sizeof(commands));
+}
+
+
+uint8_t
+ssd1306_set_screen_window(uint8_t first_column, uint8_t last_column,
+                          uint8_t first_page, uint8_t last_page) {
+	// Up to the last page of the RAM
+	uint8_t ram_page = ssd1306_get_ram_page(first_page);
+	uint8_t page_count = last_page - first_page + 1;
+	if (ram_page + page_count > SSD1306_RAM_PAGE_COUNT)
+		page_count = SSD1306_RAM_PAGE_COUNT - ram_page;
+
+	if (!ssd1306_set_window(first_column, last_column, ram_page, ram_page + page_count - 1))
+		return 0;
+
+	// Job done
+	return page_count;
+}
+
+
+uint8_t
+ssd1306_send_data(const uint8_t* data, uint16_t size) {
+	// Queued commands go first
+	if (!ssd1306_commit())
+		return 0;
+
+	return ssd1306_send(
+		SSD1306_SEND_DATA | SSD1306_SOURCE_RAM,
+		(union ssd1306_source){ .ram = data },
+		size);
+}
+
+
+uint8_t
+ssd1306_start_data(const uint8_t* data, uint16_t size) {
+	// Queued commands go first, and whatever was pending is over after that
+	uint8_t ret = ssd1306_commit() && ssd1306_wait();
+
+	ssd1306_transport_start(
+		SSD1306_SEND_DATA | SSD1306_SOURCE_RAM,
+		(union ssd1306_source){ .ram = data },
+		size);
+	ssd1306_data_pending = 1;
+
+	// Job done
+	return ret;
+}
+
+
+uint8_t
+ssd1306_wait(void) {
+	if (!ssd1306_data_pending)
+		return 1;
+
+	ssd1306_data_pending = 0;
+	return ssd1306_transport_wait();
+}
+
+
+uint8_t
+ssd1306_set_display_on(void) {
+	return ssd1306_send_command(SSD1306_DISPLAY_ON);
+}
+
+
+uint8_t
+ssd1306_set_display_off(void) {
+	return ssd1306_send_command(SSD1306_DISPLAY_OFF);
+}
+
+
+uint8_t
+ssd1306_set_normal_display_mode(void) {
+	return ssd1306_send_command(SSD1306_DIS_NORMAL);
+}
+
+
+uint8_t
+ssd1306_set_inverse_display_mode(void) {
+	return ssd1306_send_command(SSD1306_DIS_INVERSE);
+}
+
+
+uint8_t
+ssd1306_activate_scroll(void) {
+	if (ssd1306_scroll_pages == 0)
+		return 0;
+
+	ssd1306_scroll_active = 1;
+	return ssd1306_send_command(SSD1306_ACTIVE_SCROLL);
+}
+
+
+uint8_t
+ssd1306_deactivate_scroll(void) {
+	uint8_t commands[4] = {
+		SSD1306_DEACT_SCROLL,
+		SSD1306_SET_START_LINE | ssd1306_start_line,
+		SSD1306_DISPLAY_OFFSET, ssd1306_vertical_offset
+	};
+	uint8_t command_count = 1;
+
+	if (ssd1306_scroll_active) {
+		ssd1306_stale_pages |= ssd1306_scroll_pages;
+		if (ssd1306_scroll_vertical)
+			command_count = sizeof(commands);
+	}
+	ssd1306_scroll_active = 0;
+
+	return ssd1306_send_commands(commands, command_count);
+}
+
+
+// Sends a scroll setup, stops the scroll in progress first
+static uint8_t
+ssd1306_setup_scroll(const uint8_t* commands, uint8_t command_count,
+                     uint8_t first_page, uint8_t last_page, uint8_t interval, uint8_t vertical) {
+	if ((first_page > last_page) || (last_page >= SSD1306_RAM_PAGE_COUNT) || (interval > 0x07))
+		return 0;
+
+	ssd1306_begin_batch();
+	if (ssd1306_scroll_active)
+		ssd1306_deactivate_scroll();
+	ssd1306_send_commands(commands, command_count);
+	uint8_t ret = ssd1306_end_batch();
+
+	ssd1306_scroll_pages = (uint8_t)(0xff << first_page) & (uint8_t)(0xff >> (7 - last_page));
+	ssd1306_scroll_vertical = vertical;
+
+	// Job done
+	return ret;
+}
+
+
+uint8_t
+ssd1306_setup_horizontal_scroll(uint8_t first_page, uint8_t last_page, int left_to_right, uint8_t interval) {
+	uint8_t commands[7] = {
+		left_to_right ? SSD1306_RIGHT_HORIZONTAL_SCROLL : SSD1306_LEFT_HORIZONTAL_SCROLL,
+		0x00,
+		first_page,
+		interval,
+		last_page,
+		0x00,
+		0xff
+	};
+
+	return ssd1306_setup_scroll(commands, sizeof(commands), first_page, last_page, interval, 0);
+}
+
+
+uint8_t
+ssd1306_setup_diagonal_scroll(uint8_t first_page, uint8_t last_page, int left_to_right, uint8_t interval, uint8_t row_step) {
+	if (row_step >= ssd1306_scroll_area_rows)
+		return 0;
+
+	uint8_t commands[6] = {
+		left_to_right ? SSD1306_VERTICAL_AND_RIGHT_HORIZONTAL_SCROLL : SSD1306_VERTICAL_AND_LEFT_HORIZONTAL_SCROLL,
+		0x00,
+		first_page,
+		interval,
+		last_page,
+		row_step
+	};
+
+	return ssd1306_setup_scroll(commands, sizeof(commands), first_page, last_page, interval, 1);
+}
+
+
+uint8_t
+ssd1306_set_vertical_scroll_area(uint8_t first_row, uint8_t row_count) {
+	if ((row_count == 0) || (first_row + row_count > SSD1306_HEIGHT) || ssd1306_scroll_active)
+		return 0;
+
+	ssd1306_scroll_area_rows = row_count;
+
+	uint8_t commands[3] = { SSD1306_SET_VERTICAL_SCROLL_AREA, first_row, row_count };
+	return ssd1306_send_commands(commands, sizeof(commands));
+}
+
+
+uint8_t
+ssd1306_set_fade(uint8_t mode, uint8_t interval) {
+	uint8_t commands[2] = { SSD1306_SET_FADE, mode | (interval & 0x0f) };
+	return ssd1306_send_commands(commands, sizeof(commands));
+}
+
+
+uint8_t
+ssd1306_set_zoom(uint8_t on) {
+	uint8_t commands[2] = { SSD1306_SET_ZOOM, on ? 0x01 : 0x00 };
+	return ssd1306_send_commands(commands, sizeof(commands));
+}
+
+
+uint8_t
+ssd1306_set_vertical_offset(int8_t offset) {
+	ssd1306_vertical_offset = offset & 0x3f;
+
+	uint8_t commands[2] = { SSD1306_DISPLAY_OFFSET, ssd1306_vertical_offset };
+	return ssd1306_send_commands(commands, sizeof(commands));
+}
+
+
+uint8_t
+ssd1306_set_start_line(uint8_t line) {
+	ssd1306_start_line = line & 0x3f;
+	return ssd1306_send_command(SSD1306_SET_START_LINE | ssd1306_start_line);
+}
+
+
+uint8_t
+ssd1306_get_top_row(void) {
+	return (ssd1306_start_line + ssd1306_vertical_offset) & 0x3f;
+}
+
+
+uint8_t
+ssd1306_get_ram_page(uint8_t screen_page) {
+	return (ssd1306_get_top_row() / 8 + screen_page) % SSD1306_RAM_PAGE_COUNT;
+}
+
+
+uint8_t
+ssd1306_take_stale_pages(void) {
+	uint8_t ret = ssd1306_stale_pages;
+	ssd1306_stale_pages = 0;
+	return ret;
+}
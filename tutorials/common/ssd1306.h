@@ -0,0 +1,255 @@
+#ifndef SSD1306_H
+#define SSD1306_H
+
+#include <avr/io.h>
+#include <stdint.h>
+
+
+// --- SSD1306 OLED controller ------------------------------------------------
+//
+// The controller's RAM is organized in pages of 8 rows. Each byte is a column
+// of 8 pixels within a page, least significant bit at the top. In horizontal
+// addressing mode, bytes sent as data fill the current window (set with
+// ssd1306_set_window) column by column, then page by page.
+//
+// The driver talks to the controller through a transport, I2C with
+// ssd1306-twi.c or 4-wire SPI with ssd1306-spi.c, whichever is linked, see
+// ssd1306-transport.h. ssd1306_init sets it up. All the functions sleep until
+// the transfer is over, and return 1 on success, 0 on failure, except
+// ssd1306_start_data.
+//
+// Commands go through a queue, sent as a single command stream: one control
+// byte for the whole list, instead of one per byte. Between
+// ssd1306_begin_batch and ssd1306_end_batch, the commands are only queued,
+// and sent in one transaction when the batch ends, when the queue is full, or
+// before any data.
+//
+// The controller can move the picture on its own, without any bus traffic:
+// continuous scrolls, fade out, blinking, zoom. The driver keeps a model of
+// where the RAM is shown, so that partial updates land in the right place,
+// see ssd1306_get_ram_page and ssd1306_take_stale_pages.
+
+#ifndef SSD1306_COMMAND_QUEUE_SIZE
+#define SSD1306_COMMAND_QUEUE_SIZE 16
+#endif
+
+#define SSD1306_ADDRESS    0x3c
+
+// Screen geometry, 128x32 by default. Set with ie. -DSSD1306_HEIGHT=64 for
+// 128x64 screens, -DSSD1306_WIDTH=64 -DSSD1306_HEIGHT=48 for 64x48 ones.
+// Everything else derives from it at compile time.
+#ifndef SSD1306_WIDTH
+#define SSD1306_WIDTH 128
+#endif
+
+#ifndef SSD1306_HEIGHT
+#define SSD1306_HEIGHT 32
+#endif
+
+_Static_assert((SSD1306_WIDTH % 8 == 0) && (SSD1306_WIDTH <= 128), "SSD1306_WIDTH must be a multiple of 8, up to 128");
+_Static_assert((SSD1306_HEIGHT % 8 == 0) && (SSD1306_HEIGHT <= 64), "SSD1306_HEIGHT must be a multiple of 8, up to 64");
+
+#define SSD1306_PAGE_COUNT (SSD1306_HEIGHT / 8)
+
+// The controller's RAM is 64 rows high, whatever the screen shows of it
+#define SSD1306_RAM_PAGE_COUNT 8
+#define SSD1306_BUFFER_SIZE (SSD1306_WIDTH * SSD1306_PAGE_COUNT)
+
+// Narrower screens are wired to the middle columns of the controller
+#ifndef SSD1306_COLUMN_OFFSET
+#define SSD1306_COLUMN_OFFSET ((128 - SSD1306_WIDTH) / 2)
+#endif
+
+// COM pins configuration: sequential for 32 rows, alternative otherwise
+#ifndef SSD1306_COM_PINS
+#define SSD1306_COM_PINS ((SSD1306_HEIGHT == 32) ? 0x02 : 0x12)
+#endif
+
+#define SSD1306_COMMAND           0x80  // Continuation bit=1, D/C=0; 1000 0000
+#define SSD1306_COMMAND_STREAM    0x00  // Continuation bit=0, D/C=0; 0000 0000
+#define SSD1306_DATA              0xc0  // Continuation bit=1, D/C=1; 1100 0000
+#define SSD1306_DATA_STREAM       0x40  // Continuation bit=0, D/C=1; 0100 0000
+
+#define SSD1306_SET_MUX_RATIO     0xa8
+#define SSD1306_DISPLAY_OFFSET    0xd3
+#define SSD1306_DISPLAY_ON        0xaf
+#define SSD1306_DISPLAY_OFF       0xae
+#define SSD1306_DIS_ENT_DISP_ON   0xa4
+#define SSD1306_DIS_IGNORE_RAM    0xa5
+#define SSD1306_DIS_NORMAL        0xa6
+#define SSD1306_DIS_INVERSE       0xa7
+#define SSD1306_DEACT_SCROLL      0x2e
+#define SSD1306_ACTIVE_SCROLL     0x2f
+#define SSD1306_SET_START_LINE    0x40
+#define SSD1306_MEMORY_ADDR_MODE  0x20
+#define SSD1306_SET_COLUMN_ADDR   0x21
+#define SSD1306_SET_PAGE_ADDR     0x22
+#define SSD1306_SEG_REMAP         0xa0
+#define SSD1306_SEG_REMAP_OP      0xa1
+#define SSD1306_COM_SCAN_DIR      0xc0
+#define SSD1306_COM_SCAN_DIR_OP   0xc8
+#define SSD1306_COM_PIN_CONF      0xda
+#define SSD1306_SET_CONTRAST      0x81
+#define SSD1306_SET_OSC_FREQ      0xd5
+#define SSD1306_SET_CHAR_REG      0x8d
+#define SSD1306_SET_PRECHARGE     0xd9
+#define SSD1306_VCOM_DESELECT     0xdb
+
+#define SSD1306_RIGHT_HORIZONTAL_SCROLL 0x26              ///< Init rt scroll
+#define SSD1306_LEFT_HORIZONTAL_SCROLL 0x27               ///< Init left scroll
+#define SSD1306_VERTICAL_AND_RIGHT_HORIZONTAL_SCROLL 0x29 ///< Init diag scroll
+#define SSD1306_VERTICAL_AND_LEFT_HORIZONTAL_SCROLL 0x2a  ///< Init diag scroll
+#define SSD1306_SET_VERTICAL_SCROLL_AREA 0xa3             ///< Set scroll range
+#define SSD1306_SET_FADE          0x23
+#define SSD1306_SET_ZOOM          0xd6
+
+// Time between 2 steps of a continuous scroll, in frames
+#define SSD1306_SCROLL_2_FRAMES   0x07
+#define SSD1306_SCROLL_3_FRAMES   0x04
+#define SSD1306_SCROLL_4_FRAMES   0x05
+#define SSD1306_SCROLL_5_FRAMES   0x00
+#define SSD1306_SCROLL_25_FRAMES  0x06
+#define SSD1306_SCROLL_64_FRAMES  0x01
+#define SSD1306_SCROLL_128_FRAMES 0x02
+#define SSD1306_SCROLL_256_FRAMES 0x03
+
+// Fade modes, for ssd1306_set_fade
+#define SSD1306_FADE_OFF          0x00
+#define SSD1306_FADE_OUT          0x20
+#define SSD1306_BLINK             0x30
+
+
+uint8_t
+ssd1306_init(void);
+
+// Queue commands, and sends them unless a batch is in progress. Commands
+// with their arguments should not be larger than SSD1306_COMMAND_QUEUE_SIZE.
+uint8_t
+ssd1306_send_commands(const uint8_t* commands, uint8_t command_count);
+
+// Batches can be nested, the commands are sent when the outermost one ends
+void
+ssd1306_begin_batch(void);
+
+// Sends the queued commands, returns 0 if anything failed during the batch
+uint8_t
+ssd1306_end_batch(void);
+
+// Fills the whole screen with zeros, the pages of the controller's RAM it
+// shows, see ssd1306_get_ram_page
+uint8_t
+ssd1306_clear(void);
+
+// Sends SSD1306_BUFFER_SIZE bytes to the whole screen, straight from the
+// flash memory, to the pages of the controller's RAM it shows
+uint8_t
+ssd1306_upload_bitmap(const __flash uint8_t* bitmap);
+
+// Restricts the data writes to columns [first_column, last_column] of pages
+// [first_page, last_page], and moves the write position to the top-left.
+// Columns are screen columns, SSD1306_COLUMN_OFFSET is added, pages are
+// pages of the controller's RAM. Returns 0 while a scroll is active, the RAM
+// should not be written then.
+uint8_t
+ssd1306_set_window(uint8_t first_column, uint8_t last_column,
+                   uint8_t first_page, uint8_t last_page);
+
+// As ssd1306_set_window, for pages [first_page, last_page] of the screen,
+// mapped to the controller's RAM with ssd1306_get_ram_page. A window does not
+// wrap around the last page of the RAM: returns the number of screen pages
+// it covers, the following ones need another window. 0 on failure.
+uint8_t
+ssd1306_set_screen_window(uint8_t first_column, uint8_t last_column,
+                          uint8_t first_page, uint8_t last_page);
+
+// Sends size bytes as a data stream, at the write position
+uint8_t
+ssd1306_send_data(const uint8_t* data, uint16_t size);
+
+// Starts sending size bytes as a data stream, and returns right away, so that
+// the CPU can prepare the next ones meanwhile. The bytes must stay untouched
+// until ssd1306_wait returns. Returns 0 if the previous transfers failed.
+uint8_t
+ssd1306_start_data(const uint8_t* data, uint16_t size);
+
+// Sleeps until the data started with ssd1306_start_data is sent, returns 0 if
+// it failed. Any other function waits for it first.
+uint8_t
+ssd1306_wait(void);
+
+uint8_t
+ssd1306_set_display_on(void);
+
+uint8_t
+ssd1306_set_display_off(void);
+
+uint8_t
+ssd1306_set_normal_display_mode(void);
+
+uint8_t
+ssd1306_set_inverse_display_mode(void);
+
+// Starts the scroll set up last
+uint8_t
+ssd1306_activate_scroll(void);
+
+// Stops the scroll. The controller moved the RAM of the scrolled pages, by an
+// unknown amount: they become stale. The vertical position is set back to
+// what it was before a diagonal scroll.
+uint8_t
+ssd1306_deactivate_scroll(void);
+
+// Pages [first_page, last_page] of the controller's RAM move by one column
+// every interval, one of SSD1306_SCROLL_*_FRAMES. A scroll in progress is
+// stopped first. Returns 0 for invalid arguments.
+uint8_t
+ssd1306_setup_horizontal_scroll(uint8_t first_page, uint8_t last_page, int left_to_right, uint8_t interval);
+
+// As ssd1306_setup_horizontal_scroll, the vertical scroll area also moves up
+// by row_step rows every interval. row_step should be lower than the height
+// of the area.
+uint8_t
+ssd1306_setup_diagonal_scroll(uint8_t first_page, uint8_t last_page, int left_to_right, uint8_t interval, uint8_t row_step);
+
+// Rows [first_row, first_row + row_count - 1] of the screen move with a
+// diagonal scroll, the others stay. The whole screen by default.
+uint8_t
+ssd1306_set_vertical_scroll_area(uint8_t first_row, uint8_t row_count);
+
+// SSD1306_FADE_OUT dims the screen down to black, SSD1306_BLINK dims it down
+// and back up over and over, SSD1306_FADE_OFF stops either. Each contrast
+// step takes 8 * (interval + 1) frames, interval from 0 to 15.
+uint8_t
+ssd1306_set_fade(uint8_t mode, uint8_t interval);
+
+// Each row of the upper half of the screen is shown twice. Needs the
+// alternative COM pins configuration, that is screens 64 rows high.
+uint8_t
+ssd1306_set_zoom(uint8_t on);
+
+// Rows the screen is moved up by, wrapping around after the 64th
+uint8_t
+ssd1306_set_vertical_offset(int8_t offset);
+
+// First row of the controller's RAM shown at the top of the screen, the
+// following ones wrap around after the 64th
+uint8_t
+ssd1306_set_start_line(uint8_t line);
+
+// Row of the controller's RAM shown at the top of the screen, from the start
+// line and the vertical offset
+uint8_t
+ssd1306_get_top_row(void);
+
+// Page of the controller's RAM shown as a page of the screen. Moves that are
+// not a whole number of pages are rounded down.
+uint8_t
+ssd1306_get_ram_page(uint8_t screen_page);
+
+// Pages of the controller's RAM moved by a scroll since the last call, one
+// bit each, to be sent again
+uint8_t
+ssd1306_take_stale_pages(void);
+
+
+#endif /* SSD1306_H */
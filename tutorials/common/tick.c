@@ -0,0 +1,49 @@
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+
+#include "tick.h"
+
+
+_Static_assert(F_CPU == 16000000UL, "tick.c expects a 16 MHz clock");
+
+
+static volatile uint16_t tick_count;
+
+
+ISR(TIMER2_COMPA_vect) {
+	tick_count += 1;
+}
+
+
+void
+tick_init(void) {
+	tick_count = 0;
+
+	// Clear timer on compare match, prescaler 64, 250 counts
+	TCCR2A = _BV(WGM21);
+	TCCR2B = _BV(CS22);
+	OCR2A = 249;
+	TCNT2 = 0;
+	TIMSK2 |= _BV(OCIE2A);
+}
+
+
+uint16_t
+tick_now(void) {
+	// 2 bytes, thus read with interrupts disabled
+	uint8_t sreg = SREG;
+	cli();
+	uint16_t ret = tick_count;
+	SREG = sreg;
+
+	return ret;
+}
+
+
+void
+tick_sleep_until(uint16_t time) {
+	// The tick wakes the CPU up every msec
+	while(!tick_reached(tick_now(), time))
+		sleep_mode();
+}
@@ -0,0 +1,32 @@
+#ifndef TICK_H
+#define TICK_H
+
+#include <stdint.h>
+
+
+// --- Millisecond tick with Timer2 -------------------------------------------
+//
+// Timer2 in CTC mode, prescaler 64, compare match every 250 counts: an
+// interrupt every msec at 16 MHz, counted on 16 bits, wrapping after 65
+// seconds. Compare with tick_reached, which handles the wrap. Timer2 is also
+// used by the UART_STATS option of uart.c, not both.
+
+void
+tick_init(void);
+
+// Msec since tick_init
+uint16_t
+tick_now(void);
+
+// 1 if the tick is at or after time, less than 32 seconds ago
+static inline uint8_t
+tick_reached(uint16_t now, uint16_t time) {
+	return (int16_t)(now - time) >= 0;
+}
+
+// Sleeps until the tick reaches time
+void
+tick_sleep_until(uint16_t time);
+
+
+#endif /* TICK_H */
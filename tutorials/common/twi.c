@@ -0,0 +1,224 @@
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+#include <util/twi.h>
+#include <stddef.h>
+
+#include "ring.h"
+#include "twi.h"
+
+
+// Transaction queue
+RING_DEFINE(twi_queue_ring, struct twi_transaction*, TWI_QUEUE_SIZE)
+static struct twi_queue_ring twi_queue;
+
+// Transaction in progress, NULL when the bus is idle
+static struct twi_transaction* volatile twi_current;
+static uint16_t twi_write_index;
+static uint16_t twi_write_count;
+static uint16_t twi_read_index;
+
+
+// TWCR values
+#define TWI_CONTROL_NEXT  (_BV(TWINT) | _BV(TWEN) | _BV(TWIE))
+#define TWI_CONTROL_ACK   (_BV(TWINT) | _BV(TWEN) | _BV(TWIE) | _BV(TWEA))
+#define TWI_CONTROL_START (_BV(TWINT) | _BV(TWEN) | _BV(TWIE) | _BV(TWSTA))
+#define TWI_CONTROL_STOP  (_BV(TWINT) | _BV(TWEN) | _BV(TWSTO))
+
+
+// Pick the next queued transaction, if any. Interrupts must be disabled.
+static void
+twi_pop_transaction() {
+	struct twi_transaction* transaction;
+	if (!twi_queue_ring_pop(&twi_queue, &transaction)) {
+		twi_current = NULL;
+		return;
+	}
+
+	twi_current = transaction;
+	twi_write_index = 0;
+	twi_write_count = transaction->header_length + transaction->write_length;
+	twi_read_index = 0;
+}
+
+
+static uint8_t
+twi_next_write_byte(const struct twi_transaction* transaction) {
+	uint16_t i = twi_write_index++;
+	if (i < transaction->header_length)
+		return transaction->header[i];
+
+	i -= transaction->header_length;
+	if (transaction->flags & TWI_WRITE_FILL)
+		return transaction->write_buffer.ram[0];
+	if (transaction->flags & TWI_WRITE_FLASH)
+		return transaction->write_buffer.flash[i];
+	return transaction->write_buffer.ram[i];
+}
+
+
+// Close the transaction in progress, and chain with the next one
+static void
+twi_finish(uint8_t status, uint8_t control) {
+	struct twi_transaction* transaction = twi_current;
+	transaction->status = status;
+	if (transaction->callback)
+		transaction->callback(transaction);
+
+	// STOP followed by a START if there is more work to do
+	twi_pop_transaction();
+	if (twi_current)
+		control |= _BV(TWSTA) | _BV(TWIE);
+
+	TWCR = control;
+}
+
+
+ISR(TWI_vect) {
+	struct twi_transaction* transaction = twi_current;
+	uint8_t status = TW_STATUS;
+	transaction->hw_status = status;
+
+	switch(status) {
+		// Address the slave, for writing if there is anything to write
+		case TW_START:
+		case TW_REP_START:
+			if ((twi_write_index < twi_write_count) || (transaction->read_length == 0))
+				TWDR = (transaction->address << 1) | TW_WRITE;
+			else
+				TWDR = (transaction->address << 1) | TW_READ;
+			TWCR = TWI_CONTROL_NEXT;
+			break;
+
+		// Send the next byte, then either read or stop
+		case TW_MT_SLA_ACK:
+		case TW_MT_DATA_ACK:
+			if (twi_write_index < twi_write_count) {
+				TWDR = twi_next_write_byte(transaction);
+				TWCR = TWI_CONTROL_NEXT;
+			}
+			else if (transaction->read_length != 0)
+				TWCR = TWI_CONTROL_START;
+			else
+				twi_finish(TWI_OK, TWI_CONTROL_STOP);
+			break;
+
+		case TW_MT_SLA_NACK:
+		case TW_MR_SLA_NACK:
+			twi_finish(TWI_ERROR_ADDRESS_NACK, TWI_CONTROL_STOP);
+			break;
+
+		case TW_MT_DATA_NACK:
+			twi_finish(TWI_ERROR_DATA_NACK, TWI_CONTROL_STOP);
+			break;
+
+		// Release the bus without STOP
+		case TW_MT_ARB_LOST:
+			twi_finish(TWI_ERROR_ARBITRATION_LOST, _BV(TWINT) | _BV(TWEN));
+			break;
+
+		// Acknowledge every byte but the last one
+		case TW_MR_DATA_ACK:
+			transaction->read_buffer[twi_read_index++] = TWDR;
+			// Falls through
+		case TW_MR_SLA_ACK:
+			if (twi_read_index + 1 < transaction->read_length)
+				TWCR = TWI_CONTROL_ACK;
+			else
+				TWCR = TWI_CONTROL_NEXT;
+			break;
+
+		case TW_MR_DATA_NACK:
+			transaction->read_buffer[twi_read_index++] = TWDR;
+			twi_finish(TWI_OK, TWI_CONTROL_STOP);
+			break;
+
+		default:
+			twi_finish(TWI_ERROR_BUS, TWI_CONTROL_STOP);
+	}
+}
+
+
+void
+twi_init(uint8_t bitrate) {
+	// Initialize the transaction queue
+	twi_queue_ring_init(&twi_queue);
+	twi_current = NULL;
+
+	// Set pin 0 for write operation, set high
+	DDRC |= _BV(DDC4);
+	PORTC |= _BV(PORTC4);
+
+	// Set pin 1 for write operation, set high
+	DDRC |= _BV(DDC5);
+	PORTC |= _BV(PORTC5);
+
+	// TWI registers setup
+	TWSR = 0;
+	TWBR = bitrate;
+	TWCR = _BV(TWEN);
+}
+
+
+uint8_t
+twi_submit(struct twi_transaction* transaction) {
+	uint8_t ret = 0;
+	transaction->status = TWI_PENDING;
+
+	// Might be called both from the main program and from a completion
+	// callback, thus from the TWI interrupt, and might start the engine. So
+	// unlike the UART buffers, the queue needs interrupts to be disabled.
+	uint8_t sreg = SREG;
+	cli();
+
+	if (twi_queue_ring_push(&twi_queue, transaction)) {
+		ret = 1;
+
+		// Wake up the engine if the bus is idle
+		if (!twi_current) {
+			twi_pop_transaction();
+			loop_until_bit_is_clear(TWCR, TWSTO);
+			TWCR = TWI_CONTROL_START;
+		}
+	}
+
+	SREG = sreg;
+
+	// Job done
+	return ret;
+}
+
+
+uint8_t
+twi_wait(struct twi_transaction* transaction) {
+	// Sleeps until the transaction is over. Interrupts are enabled right
+	// before sleep_cpu, so that the wake-up interrupt cannot be missed.
+	cli();
+	while(transaction->status == TWI_PENDING) {
+		sleep_enable();
+		sei();
+		sleep_cpu();
+		sleep_disable();
+		cli();
+	}
+	sei();
+
+	// Job done
+	return transaction->status;
+}
+
+
+uint8_t
+twi_transfer(struct twi_transaction* transaction) {
+	// Sleeps until there is room in the queue
+	while(!twi_submit(transaction))
+		sleep_mode();
+
+	return twi_wait(transaction);
+}
+
+
+uint8_t
+twi_is_idle(void) {
+	return twi_current == NULL;
+}
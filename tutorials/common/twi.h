@@ -0,0 +1,78 @@
+#ifndef TWI_H
+#define TWI_H
+
+#include <stdint.h>
+
+
+// --- Interrupt-driven TWI master --------------------------------------------
+//
+// Transfers are described by a twi_transaction, queued with twi_submit and
+// carried out by the TWI_vect interrupt handler, one bus event at a time.
+// The caller is free to sleep, or to do something else, meanwhile.
+
+// TWBR value for a given SCL frequency, with a prescaler of 1
+#define TWI_BITRATE(f_scl) ((uint8_t)(((F_CPU / (f_scl)) - 16) / 2))
+
+// Number of transactions that can be waiting in the queue
+#define TWI_QUEUE_SIZE 4
+
+// Maximum number of bytes sent before the write buffer
+#define TWI_HEADER_SIZE 2
+
+// Where the bytes of the write buffer are taken from
+#define TWI_WRITE_RAM   0x00 // write_buffer.ram points to SRAM
+#define TWI_WRITE_FLASH 0x01 // write_buffer.flash points to flash memory
+#define TWI_WRITE_FILL  0x02 // write_buffer.ram[0] sent write_length times
+
+// Transaction status
+#define TWI_OK                     0x00
+#define TWI_PENDING                0x01 // Queued or in progress
+#define TWI_ERROR_ADDRESS_NACK     0x02 // No slave answered to the address
+#define TWI_ERROR_DATA_NACK        0x03 // Slave did not acknowledge a byte
+#define TWI_ERROR_ARBITRATION_LOST 0x04 // Another master took the bus
+#define TWI_ERROR_BUS              0x05 // Illegal START/STOP, unexpected state
+
+
+struct twi_transaction {
+	uint8_t address;                 // 7 bits slave address
+	uint8_t flags;                   // One of the TWI_WRITE_* flags
+	uint8_t header_length;
+	uint8_t header[TWI_HEADER_SIZE]; // Sent first, ie. register address or control byte
+	union {
+		const uint8_t* ram;
+		const __flash uint8_t* flash;
+	} write_buffer;
+	uint16_t write_length;
+	uint8_t* read_buffer;            // Read after the writes, with a repeated START
+	uint16_t read_length;
+
+	// Called from the TWI interrupt once the transaction is over, can be NULL
+	void (*callback)(struct twi_transaction* transaction);
+
+	volatile uint8_t status;         // One of the TWI_OK, TWI_PENDING, TWI_ERROR_*
+	volatile uint8_t hw_status;      // Last TW_STATUS value seen, for diagnostic
+};
+
+
+void
+twi_init(uint8_t bitrate);
+
+// Queue a transaction, returns 0 if the queue is full. The transaction must
+// stay alive until its status is not TWI_PENDING anymore.
+uint8_t
+twi_submit(struct twi_transaction* transaction);
+
+// Sleeps until the transaction is over, returns its status
+uint8_t
+twi_wait(struct twi_transaction* transaction);
+
+// Queue a transaction and sleeps until it is over, returns its status
+uint8_t
+twi_transfer(struct twi_transaction* transaction);
+
+// Returns 1 when there is no transaction queued or in progress
+uint8_t
+twi_is_idle(void);
+
+
+#endif /* TWI_H */
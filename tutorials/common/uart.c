@@ -0,0 +1,757 @@
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ring.h"
+#include "uart.h"
+
+
+_Static_assert(UART_BAUD_ERROR_ABS(BAUD, UART_USE_2X(BAUD)) <= UART_BAUD_MAX_ERROR,
+	"BAUD cannot be reached with less than 2.5% error");
+
+
+// Transmission ring buffer, main program to USART_UDRE_vect
+RING_DEFINE(uart_tx_ring, char, UART_TX_BUFFER_SIZE)
+static struct uart_tx_ring uart_tx;
+
+// Reception ring buffer, USART_RX_vect to main program
+RING_DEFINE(uart_rx_ring, char, UART_RX_BUFFER_SIZE)
+static struct uart_rx_ring uart_rx;
+
+// Current baud rate
+static uint32_t uart_baud;
+
+// Set when something is queued, cleared by uart_flush once it is sent: the
+// TXC interrupt clears TXC0, it is only set again by the next byte sent
+static volatile uint8_t uart_tx_used;
+
+// Flow control state
+static uint8_t uart_flow_control;
+static volatile uint8_t uart_rx_throttled; // We asked the sender to pause
+static volatile uint8_t uart_tx_paused;    // The receiver sent XOFF
+static volatile char uart_tx_control;      // XON or XOFF to send first, or 0
+
+static volatile struct uart_errors uart_errors;
+
+// Reception hook, or 0
+static uart_rx_hook uart_rx_hook_func;
+
+#ifdef UART_STATS
+static volatile struct uart_stats uart_stats;
+
+// Timer2 overflows, the high bits of the sleep time stamps
+static volatile uint16_t uart_stats_overflows;
+#endif
+
+
+#ifdef UART_FAST_ISR
+// GPIOR0 bits, set when the fast interrupt handlers have to hand over to the
+// full ones, see the end of this file
+#define UART_GPIOR_RX_FULL 0
+#define UART_GPIOR_TX_FULL 1
+
+// The full handlers are entered with a jump from the fast ones, as if they
+// were the interrupt vector. The __vector prefix keeps GCC from warning about
+// a misspelled interrupt handler.
+#define UART_ISR(vector, full) \
+	void full(void) __attribute__((signal, used)); \
+	void full(void)
+#else
+#define UART_ISR(vector, full) ISR(vector)
+#endif
+
+
+// Returns 1 if the receiver allows us to send
+static inline uint8_t
+uart_tx_is_allowed() {
+	if (uart_flow_control == UART_FLOW_RTS_CTS)
+		return bit_is_clear(UART_CTS_PIN, UART_CTS_BIT);
+	return !uart_tx_paused;
+}
+
+
+// Transmission interrupt handler, only enabled when there is something to send
+UART_ISR(USART_UDRE_vect, __vector_uart_udre_full) {
+	#ifdef UART_STATS
+	uart_stats.udre_interrupt_count += 1;
+	#endif
+
+	// A flow control character goes first, even if we are paused. The buffer
+	// can be empty if uart_putchar re-armed the interrupt while this handler
+	// was emptying the buffer.
+	char c = uart_tx_control;
+	uint8_t ready = (c != 0);
+	if (ready)
+		uart_tx_control = 0;
+	else if (uart_tx_is_allowed())
+		ready = uart_tx_ring_pop(&uart_tx, &c);
+
+	if (ready) {
+		UDR0 = c;
+
+		// Clear the transmission complete flag, FE0, DOR0 and UPE0 must be
+		// written to zero
+		UCSR0A = (UCSR0A & (_BV(U2X0) | _BV(MPCM0))) | _BV(TXC0);
+
+		#ifdef UART_STATS
+		uart_stats.tx_byte_count += 1;
+		#endif
+	}
+
+	// Nothing left to send, or not allowed to, disable the interrupt until
+	// uart_putchar, XON or CTS re-arms it
+	if (uart_tx_ring_is_empty(&uart_tx) || !uart_tx_is_allowed())
+		UCSR0B &= ~_BV(UDRIE0);
+}
+
+
+// Transmission complete interrupt handler, only enabled by uart_flush
+ISR(USART_TX_vect) {
+	UCSR0B &= ~_BV(TXCIE0);
+}
+
+
+// CTS went low, resume the transmission
+ISR(INT0_vect) {
+	UCSR0B |= _BV(UDRIE0);
+}
+
+
+// Ask the sender to pause or to resume, with XOFF/XON or RTS, unless it was
+// already asked to. Interrupts should be disabled.
+static void
+uart_rx_set_throttled(uint8_t throttled) {
+	if ((uart_flow_control == UART_FLOW_NONE) || (uart_rx_throttled == throttled))
+		return;
+
+	uart_rx_throttled = throttled;
+	if (uart_flow_control == UART_FLOW_XON_XOFF) {
+		uart_tx_control = throttled ? UART_XOFF : UART_XON;
+		uart_tx_used = 1;
+		UCSR0B |= _BV(UDRIE0);
+	}
+	else if (throttled)
+		UART_RTS_PORT |= _BV(UART_RTS_BIT);
+	else
+		UART_RTS_PORT &= ~_BV(UART_RTS_BIT);
+}
+
+
+// Reception interrupt handler
+UART_ISR(USART_RX_vect, __vector_uart_rx_full) {
+	// Error flags are only valid until UDR0 is read. UDR0 is always read, so
+	// that the hardware does not overrun while the buffer is full.
+	uint8_t status = UCSR0A;
+	char c = UDR0;
+
+	if (status & _BV(DOR0))
+		uart_errors.data_overruns += 1;
+
+	if (status & _BV(FE0)) {
+		uart_errors.frame_errors += 1;
+		return;
+	}
+
+	// XON and XOFF from the receiver
+	if (uart_flow_control == UART_FLOW_XON_XOFF) {
+		if (c == UART_XOFF) {
+			uart_tx_paused = 1;
+			return;
+		}
+		if (c == UART_XON) {
+			uart_tx_paused = 0;
+			UCSR0B |= _BV(UDRIE0);
+			return;
+		}
+	}
+
+	// Bytes taken by the hook are not stored
+	if (uart_rx_hook_func && uart_rx_hook_func(c))
+		return;
+
+	if (!uart_rx_ring_push(&uart_rx, c)) {
+		uart_errors.dropped += 1;
+		return;
+	}
+
+	// Ask the sender to pause when reaching the high watermark
+	if (uart_rx_ring_count(&uart_rx) >= UART_RX_HIGH_WATERMARK)
+		uart_rx_set_throttled(1);
+}
+
+
+// Ask the sender to resume when the reception buffer is drained down to the
+// low watermark. Called after reading from the reception buffer.
+static void
+uart_rx_release() {
+	if (!uart_rx_throttled || (uart_rx_ring_count(&uart_rx) > UART_RX_LOW_WATERMARK))
+		return;
+
+	cli();
+	uart_rx_set_throttled(0);
+	sei();
+}
+
+
+void
+uart_rx_throttle(uint8_t pause) {
+	uint8_t sreg = SREG;
+	cli();
+	uart_rx_set_throttled(pause);
+	SREG = sreg;
+}
+
+
+// Picks the fast or the full interrupt handlers, according to the features in
+// use. Interrupts must be disabled.
+static void
+uart_select_isr() {
+	#ifdef UART_FAST_ISR
+	uint8_t full = 0;
+	if (uart_flow_control != UART_FLOW_NONE)
+		full |= _BV(UART_GPIOR_RX_FULL) | _BV(UART_GPIOR_TX_FULL);
+	if (uart_rx_hook_func)
+		full |= _BV(UART_GPIOR_RX_FULL);
+	#ifdef UART_STATS
+	full |= _BV(UART_GPIOR_TX_FULL);
+	#endif
+
+	GPIOR0 = (GPIOR0 & ~(_BV(UART_GPIOR_RX_FULL) | _BV(UART_GPIOR_TX_FULL))) | full;
+	#endif
+}
+
+
+#ifdef UART_STATS
+ISR(TIMER2_OVF_vect) {
+	uart_stats_overflows += 1;
+}
+
+
+// Timer2 ticks, over 24 bits. Interrupts must be disabled: an overflow not
+// handled yet is still pending in TOV2.
+static uint32_t
+uart_stats_get_time() {
+	uint16_t high = uart_stats_overflows;
+	uint8_t low = TCNT2;
+	if ((TIFR2 & _BV(TOV2)) && (low < 255))
+		high += 1;
+
+	return ((uint32_t)high << 8) | low;
+}
+#endif
+
+
+// Sleeps until the next interrupt. Must be called with interrupts disabled,
+// returns with interrupts disabled. Interrupts are enabled right before
+// sleep_cpu, so that the wake-up interrupt cannot be missed.
+static void
+uart_sleep() {
+	#ifdef UART_STATS
+	uint32_t start = uart_stats_get_time();
+	#endif
+
+	sleep_enable();
+	sei();
+	sleep_cpu();
+	sleep_disable();
+	cli();
+
+	#ifdef UART_STATS
+	uart_stats.sleep_ticks += (uart_stats_get_time() - start) & 0xffffffUL;
+	#endif
+}
+
+
+void
+uart_init(void) {
+	// Initialize transmission and reception buffers
+	uart_tx_ring_init(&uart_tx);
+	uart_rx_ring_init(&uart_rx);
+	uart_tx_used = 0;
+
+	// No flow control, no errors so far
+	uart_flow_control = UART_FLOW_NONE;
+	uart_rx_throttled = 0;
+	uart_tx_paused = 0;
+	uart_tx_control = 0;
+	memset((void*)&uart_errors, 0, sizeof(uart_errors));
+	uart_rx_hook_func = 0;
+	uart_select_isr();
+
+	// Setup transmission rate, computed at compile time
+	uart_baud = BAUD;
+	UBRR0 = UART_UBRR(BAUD, UART_USE_2X(BAUD));
+
+	#if UART_USE_2X(BAUD)
+	UCSR0A |= _BV(U2X0);
+	#else
+	UCSR0A &= ~(_BV(U2X0));
+	#endif
+
+	UCSR0C = _BV(UCSZ01) | _BV(UCSZ00); // Setup data format, async transmission
+	UCSR0B = _BV(RXEN0) | _BV(TXEN0);   // Enable reception and transmission
+
+	UCSR0B |= _BV(RXCIE0); // Enable reception interrupt
+
+	// Timer2 free running, prescaler set to 256, overflows counted
+	#ifdef UART_STATS
+	memset((void*)&uart_stats, 0, sizeof(uart_stats));
+	uart_stats_overflows = 0;
+	TCCR2A = 0;
+	TCCR2B = _BV(CS22) | _BV(CS21);
+	TCNT2 = 0;
+	TIFR2 = _BV(TOV2);
+	TIMSK2 = _BV(TOIE2);
+	#endif
+}
+
+
+// Picks the setting with the lowest error, same logic as UART_USE_2X.
+// Returns INT16_MAX if no setting fits.
+static int16_t
+uart_compute_baud(uint32_t baud, uint16_t* ubrr, uint8_t* u2x) {
+	// Above F_CPU / 8, the divisor overflows and no setting fits anyway
+	int16_t best_error = INT16_MAX;
+	if ((baud == 0) || (baud > F_CPU / 8))
+		return best_error;
+
+	for(uint8_t i = 0; i < 2; ++i) {
+		uint32_t divisor = UART_DIVISOR(i) * baud;
+		uint32_t value = (F_CPU + divisor / 2) / divisor;
+		if ((value == 0) || (value > 4096))
+			continue;
+
+		int32_t actual = F_CPU / (UART_DIVISOR(i) * value);
+		int16_t error = (1000 * (actual - (int32_t)baud)) / (int32_t)baud;
+		if ((*ubrr > 4095) || (abs(error) < abs(best_error))) {
+			*ubrr = value - 1;
+			*u2x = i;
+			best_error = error;
+		}
+	}
+
+	return best_error;
+}
+
+
+int16_t
+uart_baud_error(uint32_t baud) {
+	uint16_t ubrr = 0xffff;
+	uint8_t u2x;
+	return uart_compute_baud(baud, &ubrr, &u2x);
+}
+
+
+int16_t
+uart_set_baud(uint32_t baud) {
+	uint16_t ubrr = 0xffff;
+	uint8_t u2x;
+	int16_t error = uart_compute_baud(baud, &ubrr, &u2x);
+	if (ubrr > 4095)
+		return error;
+
+	// Do not cut the last bytes sent at the previous rate
+	uart_flush();
+
+	// Writing UBRR0L updates the rate, UBRR0H has to be written first
+	uart_baud = baud;
+	UBRR0 = ubrr;
+	if (u2x)
+		UCSR0A |= _BV(U2X0);
+	else
+		UCSR0A &= ~(_BV(U2X0));
+
+	// Job done
+	return error;
+}
+
+
+uint32_t
+uart_get_baud(void) {
+	return uart_baud;
+}
+
+
+void
+uart_set_flow_control(uint8_t mode) {
+	cli();
+
+	uart_flow_control = mode;
+	uart_rx_throttled = 0;
+	uart_tx_paused = 0;
+	uart_tx_control = 0;
+
+	if (mode == UART_FLOW_RTS_CTS) {
+		// RTS as output, low since we are ready to receive
+		UART_RTS_DDR |= _BV(UART_RTS_BIT);
+		UART_RTS_PORT &= ~_BV(UART_RTS_BIT);
+
+		// CTS as input with pull-up, INT0 triggers on falling edge
+		UART_CTS_DDR &= ~_BV(UART_CTS_BIT);
+		UART_CTS_PORT |= _BV(UART_CTS_BIT);
+		EICRA = (EICRA & ~(_BV(ISC00) | _BV(ISC01))) | _BV(ISC01);
+		EIFR = _BV(INTF0);
+		EIMSK |= _BV(INT0);
+	}
+	else
+		EIMSK &= ~_BV(INT0);
+
+	uart_select_isr();
+
+	// Whatever was paused might be sent now
+	UCSR0B |= _BV(UDRIE0);
+
+	sei();
+}
+
+
+void
+uart_get_errors(struct uart_errors* errors) {
+	cli();
+	memcpy(errors, (const void*)&uart_errors, sizeof(uart_errors));
+	memset((void*)&uart_errors, 0, sizeof(uart_errors));
+	sei();
+}
+
+
+void
+uart_set_rx_hook(uart_rx_hook hook) {
+	cli();
+	uart_rx_hook_func = hook;
+	uart_select_isr();
+	sei();
+}
+
+
+#ifdef UART_STATS
+void
+uart_get_stats(struct uart_stats* stats) {
+	cli();
+	memcpy(stats, (const void*)&uart_stats, sizeof(uart_stats));
+	memset((void*)&uart_stats, 0, sizeof(uart_stats));
+	sei();
+}
+#endif
+
+
+// --- Bulk transfers ---------------------------------------------------------
+
+// Arm the UDRE interrupt, after adding data to the transmission buffer
+static inline void
+uart_tx_arm() {
+	uart_tx_used = 1;
+	UCSR0B |= _BV(UDRIE0);
+}
+
+
+uint16_t
+uart_try_write(const void* data, uint16_t size) {
+	const char* ptr = data;
+	uint16_t left = size;
+
+	// Copy by chunks, as long as the UDRE interrupt makes room
+	while(left != 0) {
+		uint8_t count = uart_tx_ring_push_n(&uart_tx, ptr, left > 0xff ? 0xff : left);
+		if (count == 0)
+			break;
+
+		uart_tx_arm();
+		ptr += count;
+		left -= count;
+	}
+
+	// Job done
+	return size - left;
+}
+
+
+uint16_t
+uart_try_read(void* data, uint16_t size) {
+	char* ptr = data;
+	uint16_t left = size;
+
+	// Copy by chunks, as long as the RX interrupt brings data
+	while(left != 0) {
+		uint8_t count = uart_rx_ring_pop_n(&uart_rx, ptr, left > 0xff ? 0xff : left);
+		if (count == 0)
+			break;
+
+		ptr += count;
+		left -= count;
+	}
+
+	uart_rx_release();
+
+	// Job done
+	return size - left;
+}
+
+
+void
+uart_write(const void* data, uint16_t size) {
+	const char* ptr = data;
+	while(1) {
+		uint16_t count = uart_try_write(ptr, size);
+		ptr += count;
+		size -= count;
+		if (size == 0)
+			break;
+
+		// Sleeps until there is room available in the transmission buffer
+		cli();
+		while(uart_tx_ring_is_full(&uart_tx))
+			uart_sleep();
+		sei();
+	}
+}
+
+
+void
+uart_read(void* data, uint16_t size) {
+	char* ptr = data;
+	while(1) {
+		uint16_t count = uart_try_read(ptr, size);
+		ptr += count;
+		size -= count;
+		if (size == 0)
+			break;
+
+		// Sleeps until there are data available in the reception buffer
+		cli();
+		while(uart_rx_ring_is_empty(&uart_rx))
+			uart_sleep();
+		sei();
+	}
+}
+
+
+void
+uart_flush(void) {
+	if (!uart_tx_used)
+		return;
+
+	cli();
+
+	// Sleeps until the transmission buffer is empty
+	while(!uart_tx_ring_is_empty(&uart_tx))
+		uart_sleep();
+
+	// Sleeps until the last byte is out of the shift register. TXC0 is still
+	// set if that happened already, then the interrupt triggers right away.
+	UCSR0B |= _BV(TXCIE0);
+	while(UCSR0B & _BV(TXCIE0))
+		uart_sleep();
+
+	// Nothing left to wait for until the next byte is queued
+	uart_tx_used = 0;
+
+	sei();
+}
+
+
+// --- Setup to use stdio function for serial communications ------------------
+
+int
+uart_putchar(char c, FILE *stream) {
+	// Sleeps until there is room available in the transmission buffer
+	if (uart_tx_ring_is_full(&uart_tx)) {
+		cli();
+		while(uart_tx_ring_is_full(&uart_tx))
+			uart_sleep();
+		sei();
+	}
+
+	// Add the character in the transmission buffer, arm the UDRE interrupt
+	uart_tx_ring_push(&uart_tx, c);
+	uart_tx_arm();
+
+	// Job done
+	return 0;
+}
+
+
+int
+uart_getchar(FILE *stream) {
+	// Sleeps until there are data available in the reception buffer
+	if (uart_rx_ring_is_empty(&uart_rx)) {
+		cli();
+		while(uart_rx_ring_is_empty(&uart_rx))
+			uart_sleep();
+		sei();
+	}
+
+	// Pick the first character in the reception buffer
+	char ret;
+	uart_rx_ring_pop(&uart_rx, &ret);
+	uart_rx_release();
+
+	// Job done
+	return ret;
+}
+
+
+FILE uart_output =
+	FDEV_SETUP_STREAM(uart_putchar, NULL, _FDEV_SETUP_WRITE);
+
+FILE uart_input =
+	FDEV_SETUP_STREAM(NULL, uart_getchar, _FDEV_SETUP_READ);
+
+FILE uart_io =
+	FDEV_SETUP_STREAM(uart_putchar, uart_getchar, _FDEV_SETUP_RW);
+
+
+// --- Fast interrupt handlers ------------------------------------------------
+//
+// With UART_FAST_ISR, USART_RX_vect and USART_UDRE_vect are written in
+// assembly, and only save the 4 registers they use, instead of the prologue
+// GCC generates for the C handlers, which saves every call-clobbered register
+// since the reception handler calls the hook. They only handle the common
+// case, moving one byte between UDR0 and a ring buffer. Whenever something
+// else is needed (flow control, reception hook, reception error, statistics),
+// they jump to the C handlers above, before touching anything. That is
+// decided by two bits of GPIOR0, tested with a single sbic.
+
+#ifdef UART_FAST_ISR
+ISR(USART_RX_vect, ISR_NAKED) {
+	__asm__ __volatile__(
+		"sbic %[gpior], %[full_bit]\n\t"
+		"jmp __vector_uart_rx_full\n\t"
+		"push r24\n\t"
+		"in r24, __SREG__\n\t"
+		"push r24\n\t"
+
+		// Reception error, restore and hand over to the full handler
+		"lds r24, %[ucsra]\n\t"
+		"andi r24, %[error_mask]\n\t"
+		"breq 1f\n\t"
+		"pop r24\n\t"
+		"out __SREG__, r24\n\t"
+		"pop r24\n\t"
+		"jmp __vector_uart_rx_full\n"
+	"1:\n\t"
+		"push r25\n\t"
+		"push r30\n\t"
+		"push r31\n\t"
+
+		// Buffer full if head - tail is the buffer size
+		"lds r24, %[tail]\n\t"
+		"lds r25, %[head]\n\t"
+		"mov r30, r25\n\t"
+		"sub r30, r24\n\t"
+		"cpi r30, %[size]\n\t"
+		"breq 3f\n\t"
+
+		// data[head & mask] = UDR0, then head += 1
+		"mov r30, r25\n\t"
+		"andi r30, %[mask]\n\t"
+		"ldi r31, 0\n\t"
+		"subi r30, lo8(-(%[data]))\n\t"
+		"sbci r31, hi8(-(%[data]))\n\t"
+		"lds r24, %[udr]\n\t"
+		"st Z, r24\n\t"
+		"subi r25, 0xff\n\t"
+		"sts %[head], r25\n"
+	"2:\n\t"
+		"pop r31\n\t"
+		"pop r30\n\t"
+		"pop r25\n\t"
+		"pop r24\n\t"
+		"out __SREG__, r24\n\t"
+		"pop r24\n\t"
+		"reti\n"
+
+		// Buffer full, UDR0 is read anyway and the byte is counted as dropped
+	"3:\n\t"
+		"lds r24, %[udr]\n\t"
+		"lds r24, %[dropped]\n\t"
+		"lds r25, %[dropped]+1\n\t"
+		"adiw r24, 1\n\t"
+		"sts %[dropped]+1, r25\n\t"
+		"sts %[dropped], r24\n\t"
+		"rjmp 2b\n\t"
+		:
+		: [gpior] "I" (_SFR_IO_ADDR(GPIOR0)),
+		  [full_bit] "I" (UART_GPIOR_RX_FULL),
+		  [ucsra] "n" (_SFR_MEM_ADDR(UCSR0A)),
+		  [udr] "n" (_SFR_MEM_ADDR(UDR0)),
+		  [error_mask] "M" (_BV(FE0) | _BV(DOR0)),
+		  [head] "i" (&uart_rx.head),
+		  [tail] "i" (&uart_rx.tail),
+		  [data] "i" (uart_rx.data),
+		  [size] "M" (UART_RX_BUFFER_SIZE),
+		  [mask] "M" (UART_RX_BUFFER_SIZE - 1),
+		  [dropped] "i" (&uart_errors.dropped)
+	);
+}
+
+
+ISR(USART_UDRE_vect, ISR_NAKED) {
+	__asm__ __volatile__(
+		"sbic %[gpior], %[full_bit]\n\t"
+		"jmp __vector_uart_udre_full\n\t"
+		"push r24\n\t"
+		"in r24, __SREG__\n\t"
+		"push r24\n\t"
+		"push r25\n\t"
+		"push r30\n\t"
+		"push r31\n\t"
+
+		// Buffer empty if head == tail
+		"lds r24, %[tail]\n\t"
+		"lds r25, %[head]\n\t"
+		"cp r24, r25\n\t"
+		"breq 2f\n\t"
+
+		// UDR0 = data[tail & mask]
+		"mov r30, r24\n\t"
+		"andi r30, %[mask]\n\t"
+		"ldi r31, 0\n\t"
+		"subi r30, lo8(-(%[data]))\n\t"
+		"sbci r31, hi8(-(%[data]))\n\t"
+		"ld r25, Z\n\t"
+		"sts %[udr], r25\n\t"
+
+		// Clear the transmission complete flag, see the C handler
+		"lds r25, %[ucsra]\n\t"
+		"andi r25, %[ucsra_keep]\n\t"
+		"ori r25, %[txc]\n\t"
+		"sts %[ucsra], r25\n\t"
+
+		// tail += 1, done if there is more to send
+		"subi r24, 0xff\n\t"
+		"sts %[tail], r24\n\t"
+		"lds r25, %[head]\n\t"
+		"cpse r24, r25\n\t"
+		"rjmp 1f\n"
+
+		// Nothing left to send, disable the interrupt
+	"2:\n\t"
+		"lds r24, %[ucsrb]\n\t"
+		"andi r24, %[no_udrie]\n\t"
+		"sts %[ucsrb], r24\n"
+	"1:\n\t"
+		"pop r31\n\t"
+		"pop r30\n\t"
+		"pop r25\n\t"
+		"pop r24\n\t"
+		"out __SREG__, r24\n\t"
+		"pop r24\n\t"
+		"reti\n\t"
+		:
+		: [gpior] "I" (_SFR_IO_ADDR(GPIOR0)),
+		  [full_bit] "I" (UART_GPIOR_TX_FULL),
+		  [ucsra] "n" (_SFR_MEM_ADDR(UCSR0A)),
+		  [ucsrb] "n" (_SFR_MEM_ADDR(UCSR0B)),
+		  [udr] "n" (_SFR_MEM_ADDR(UDR0)),
+		  [ucsra_keep] "M" (_BV(U2X0) | _BV(MPCM0)),
+		  [txc] "M" (_BV(TXC0)),
+		  [no_udrie] "M" ((uint8_t)~_BV(UDRIE0)),
+		  [head] "i" (&uart_tx.head),
+		  [tail] "i" (&uart_tx.tail),
+		  [data] "i" (uart_tx.data),
+		  [mask] "M" (UART_TX_BUFFER_SIZE - 1)
+	);
+}
+#endif /* UART_FAST_ISR */
@@ -0,0 +1,190 @@
+#ifndef UART_H
+#define UART_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+
+// --- Interrupt-driven UART --------------------------------------------------
+//
+// Transmission and reception go through ring buffers, filled and emptied by
+// the USART_UDRE_vect and USART_RX_vect interrupt handlers. The UDRE
+// interrupt is only enabled while there is something to send, so that the
+// MCU can actually sleep when the transmission buffer is empty.
+//
+// Building uart.c with -DUART_FAST_ISR replaces both handlers with assembly
+// versions for the common case, see the end of uart.c. They use bits 0 and 1
+// of GPIOR0, which must then be left alone by the rest of the program.
+
+// Baud rate settings. In normal mode the UART samples each bit 16 times, 8
+// times in double speed mode (U2X0 set), which allows twice faster rates and
+// finer steps, at the cost of a less robust reception. The setting with the
+// lowest error is picked, normal mode in case of a tie.
+#ifndef BAUD
+#define BAUD 9600
+#endif
+
+#define UART_DIVISOR(u2x) ((u2x) ? 8UL : 16UL)
+#define UART_UBRR(baud, u2x) \
+	((F_CPU + UART_DIVISOR(u2x) * (baud) / 2) / (UART_DIVISOR(u2x) * (baud)) - 1)
+#define UART_ACTUAL_BAUD(baud, u2x) \
+	(F_CPU / (UART_DIVISOR(u2x) * (UART_UBRR(baud, u2x) + 1)))
+
+// Absolute difference between actual and requested rate, in 1/1000 of the
+// requested rate. No casts, so that it can be used with #if.
+#define UART_BAUD_ERROR_ABS(baud, u2x) \
+	((UART_ACTUAL_BAUD(baud, u2x) > (baud)) ? \
+		(1000 * (UART_ACTUAL_BAUD(baud, u2x) - (baud))) / (baud) : \
+		(1000 * ((baud) - UART_ACTUAL_BAUD(baud, u2x))) / (baud))
+
+#define UART_USE_2X(baud) \
+	((UART_UBRR(baud, 1) <= 4095) && \
+	 ((UART_UBRR(baud, 0) > 4095) || (UART_BAUD_ERROR_ABS(baud, 1) < UART_BAUD_ERROR_ABS(baud, 0))))
+
+// Above 2.5% error, the reception is not reliable anymore. 115200 is 2.1% off
+// at 16 MHz, it works fine with the UNO's on-board USB-serial chip.
+#define UART_BAUD_MAX_ERROR 25
+
+
+#ifndef UART_TX_BUFFER_SIZE
+#define UART_TX_BUFFER_SIZE 16
+#endif
+
+#ifndef UART_RX_BUFFER_SIZE
+#define UART_RX_BUFFER_SIZE 32
+#endif
+
+
+// Flow control. When the reception buffer fills up to the high watermark,
+// the sender is asked to pause, either with a XOFF character or by
+// deasserting RTS. It is asked to resume, with XON or RTS, once the buffer is
+// drained down to the low watermark. With XON/XOFF, the XON and XOFF
+// characters received are not stored, thus it is only for text.
+#define UART_FLOW_NONE     0
+#define UART_FLOW_XON_XOFF 1
+#define UART_FLOW_RTS_CTS  2
+
+#define UART_XON  0x11
+#define UART_XOFF 0x13
+
+#ifndef UART_RX_HIGH_WATERMARK
+#define UART_RX_HIGH_WATERMARK (UART_RX_BUFFER_SIZE * 3 / 4)
+#endif
+
+#ifndef UART_RX_LOW_WATERMARK
+#define UART_RX_LOW_WATERMARK (UART_RX_BUFFER_SIZE / 4)
+#endif
+
+// RTS output, pin 4 of PORTD, low when we are ready to receive
+#define UART_RTS_DDR  DDRD
+#define UART_RTS_PORT PORTD
+#define UART_RTS_BIT  PORTD4
+
+// CTS input, pin 2 of PORTD (INT0), low when we are allowed to send
+#define UART_CTS_DDR  DDRD
+#define UART_CTS_PORT PORTD
+#define UART_CTS_PIN  PIND
+#define UART_CTS_BIT  PIND2
+
+
+// Reception errors, counted by the USART_RX_vect interrupt handler
+struct uart_errors {
+	uint16_t frame_errors;  // Bytes with a bad stop bit, not stored
+	uint16_t data_overruns; // Hardware overruns, bytes lost before we read UDR0
+	uint16_t dropped;       // Bytes not stored because the buffer was full
+};
+
+
+#ifdef UART_STATS
+// Counters to check what the UART costs. Sleep time is measured with Timer2,
+// free running with a 256 prescaler, thus 16 usec per tick. Its overflow
+// interrupt counts the high bits, and wakes the MCU every 4.096 msec: each
+// sleep is measured right up to 268 sec.
+#define UART_STATS_USEC_PER_TICK 16
+
+struct uart_stats {
+	uint16_t udre_interrupt_count; // USART_UDRE_vect entries
+	uint16_t tx_byte_count;        // Bytes written to UDR0
+	uint32_t sleep_ticks;          // Time spent sleeping in uart_* functions
+};
+
+// Copy the counters, then reset them
+void
+uart_get_stats(struct uart_stats* stats);
+#endif
+
+
+// Setup the UART at the BAUD rate, known at compile time
+void
+uart_init(void);
+
+// Error of the best setting for a given rate, in 1/1000 of the rate.
+// INT16_MAX if the rate cannot be reached at all.
+int16_t
+uart_baud_error(uint32_t baud);
+
+// Sleeps until the transmission buffer is sent, then switches to the given
+// rate. Returns the error of the setting, in 1/1000 of the rate, or
+// INT16_MAX if the rate cannot be reached, then the rate does not change.
+int16_t
+uart_set_baud(uint32_t baud);
+
+// Rate given to uart_set_baud, or BAUD
+uint32_t
+uart_get_baud(void);
+
+// One of the UART_FLOW_* values, UART_FLOW_NONE by default
+void
+uart_set_flow_control(uint8_t mode);
+
+// Copy the reception error counters, then reset them
+void
+uart_get_errors(struct uart_errors* errors);
+
+// Reception hook, called by the USART_RX_vect interrupt handler for each byte
+// received without error, before it is stored. If the hook returns non-zero,
+// the byte is consumed and not stored in the reception buffer. 0 to remove it.
+typedef uint8_t (*uart_rx_hook)(char c);
+
+void
+uart_set_rx_hook(uart_rx_hook hook);
+
+// For a reception hook that stores the bytes elsewhere, where the watermarks
+// do not apply: 1 asks the sender to pause, 0 to resume, with the flow
+// control of uart_set_flow_control. Also from the hook itself.
+void
+uart_rx_throttle(uint8_t pause);
+
+// Queue as many bytes as there is room for, returns how many were queued
+uint16_t
+uart_try_write(const void* data, uint16_t size);
+
+// Read as many bytes as available, up to size, returns how many were read
+uint16_t
+uart_try_read(void* data, uint16_t size);
+
+// Sleeps until all the bytes are queued
+void
+uart_write(const void* data, uint16_t size);
+
+// Sleeps until size bytes are read
+void
+uart_read(void* data, uint16_t size);
+
+// Sleeps until the last queued byte has left the transmission shift register
+void
+uart_flush(void);
+
+int
+uart_putchar(char c, FILE *stream);
+
+int
+uart_getchar(FILE *stream);
+
+
+extern FILE uart_output;
+extern FILE uart_input;
+extern FILE uart_io;
+
+
+#endif /* UART_H */
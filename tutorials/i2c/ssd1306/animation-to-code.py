@@ -0,0 +1,94 @@
+import sys
+import array
+import argparse
+import importlib
+
+bitmap_to_code = importlib.import_module('bitmap-to-code')
+
+
+KEYFRAME = 0xff
+
+# A span costs 3 bytes : page, first column, length
+SPAN_COST = 3
+
+
+def encode_delta(previous, current, width):
+    # XOR of the changed bytes, in spans of a page. Spans separated by fewer
+    # unchanged bytes than the cost of a span are merged.
+    spans = []
+    for page in range(len(current) // width):
+        x = 0
+        while x < width:
+            i = page * width + x
+            if previous[i] == current[i]:
+                x += 1
+                continue
+
+            first = last = x
+            while x < width and x - last <= SPAN_COST:
+                i = page * width + x
+                if previous[i] != current[i]:
+                    last = x
+                x += 1
+            spans.append((page, first, last))
+
+    if len(spans) >= KEYFRAME:
+        return None
+
+    out = array.array('B', [len(spans)])
+    for page, first, last in spans:
+        out.extend([page, first, last - first + 1])
+        out.extend(previous[page * width + x] ^ current[page * width + x] for x in range(first, last + 1))
+    return out
+
+
+def main():
+    # Command line arguments
+    parser = argparse.ArgumentParser(description = 'Convert a strip of pictures, one frame under the other, to a delta encoded animation for a SSD1306 oled screen')
+    parser.add_argument('--array-name', default = 'animation_data')
+    parser.add_argument('--width', type = int, default = 128, help = 'screen width, as SSD1306_WIDTH')
+    parser.add_argument('--height', type = int, default = 32, help = 'screen height, as SSD1306_HEIGHT')
+    parser.add_argument('--frame-count', type = int, required = True, help = 'frames in the strip')
+    parser.add_argument('input_path')
+
+    args = parser.parse_args()
+    if args.height % 8 != 0:
+        parser.error('the height should be a multiple of 8')
+
+    img = bitmap_to_code.load_picture(args.input_path)
+    frame_height = img.shape[0] // args.frame_count
+    if (frame_height, img.shape[1]) != (args.height, args.width):
+        print(f'warning: {img.shape[1]}x{frame_height} frames on a {args.width}x{args.height} screen, centered', file = sys.stderr)
+
+    # The first frame is a keyframe, the following ones are deltas, unless
+    # the keyframe is smaller
+    data = array.array('B')
+    previous = None
+    keyframe_count = 0
+    for k in range(args.frame_count):
+        current = bitmap_to_code.to_pages(img, args.width, args.height, k * frame_height, frame_height)
+        keyframe = array.array('B', [KEYFRAME]) + bitmap_to_code.rle_encode(current)
+        delta = encode_delta(previous, current, args.width) if previous is not None else None
+        if delta is None or len(delta) >= len(keyframe):
+            data.extend(keyframe)
+            keyframe_count += 1
+        else:
+            data.extend(delta)
+        previous = current
+
+    raw_size = args.frame_count * args.width * args.height // 8
+    print(f'{args.frame_count} frames, {keyframe_count} keyframes, {raw_size} bytes, {len(data)} bytes encoded, {100 * len(data) / raw_size:.1f}%', file = sys.stderr)
+
+    # Generate C code, checked against the geometry the driver is built for
+    print('#include <stdint.h>')
+    print('#include "ssd1306.h"')
+    print(f'_Static_assert((SSD1306_WIDTH == {args.width}) && (SSD1306_HEIGHT == {args.height}), "animation generated for a {args.width}x{args.height} screen");')
+    print(f'#define {args.array_name.upper()}_FRAME_COUNT {args.frame_count}')
+    print('const __flash uint8_t')
+    print(f'{args.array_name}[{len(data)}] = {{')
+    print(', '.join(f'0x{byte:02x}'for byte in data))
+    print('};')
+
+
+if __name__ == "__main__":
+    main()
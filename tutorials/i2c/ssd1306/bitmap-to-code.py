@@ -1,3 +1,4 @@
+import sys
 import math
 import array
 import argparse
@@ -6,35 +7,113 @@ import skimage.io
 import skimage.filters
 
 
+def load_picture(path):
+    # Load the input as gray scale
+    img = skimage.io.imread(path, as_gray = True)
+
+    # Filter the input to enforce a 1 bit image
+    threshold = skimage.filters.threshold_otsu(img)
+    return img > threshold
+
+
+def to_pages(img, width, height, first_row = 0, row_count = None):
+    # Rows [first_row, first_row + row_count) of the picture, centered on the
+    # screen, cropped or padded with black
+    if row_count is None:
+        row_count = img.shape[0]
+    top = first_row + (row_count - height) // 2
+    left = (img.shape[1] - width) // 2
+
+    # Convertion to a byte array, page after page
+    scanline_list = [array.array('B', [0] * width) for i in range(height // 8)]
+    for i in range(height):
+        for j in range(width):
+            u, v = top + i, left + j
+            if first_row <= u < first_row + row_count and 0 <= v < img.shape[1] and img[u][v]:
+                scanline_list[i // 8][j] |= 1 << (i % 8)
+
+    return array.array('B', itertools.chain(*scanline_list))
+
+
+def rle_encode(data):
+    # Runs of 3 bytes or more are repeated, everything else is copied, see
+    # common/rle.h for the format
+    out = array.array('B')
+    literals = []
+
+    def flush_literals():
+        for k in range(0, len(literals), 128):
+            chunk = literals[k:k + 128]
+            out.append(len(chunk) - 1)
+            out.extend(chunk)
+        literals.clear()
+
+    i = 0
+    while i < len(data):
+        run = 1
+        while i + run < len(data) and run < 129 and data[i + run] == data[i]:
+            run += 1
+        if run >= 3:
+            flush_literals()
+            out.append(0x80 | (run - 2))
+            out.append(data[i])
+        else:
+            literals.extend(data[i:i + run])
+        i += run
+    flush_literals()
+
+    return out
+
+
+def rle_decode(data, size):
+    out = array.array('B')
+    i = 0
+    while len(out) < size:
+        control = data[i]
+        if control & 0x80:
+            out.extend([data[i + 1]] * ((control & 0x7f) + 2))
+            i += 2
+        else:
+            out.extend(data[i + 1:i + control + 2])
+            i += control + 2
+    return out
+
+
 def main():
     # Command line arguments
     parser = argparse.ArgumentParser(description = 'Convert a bitmap picture to raw data for a SSD1306 oled screen in horizontal addressing mode')
     parser.add_argument('--array-name', default = 'bitmap_data')
+    parser.add_argument('--width', type = int, default = 128, help = 'screen width, as SSD1306_WIDTH')
+    parser.add_argument('--height', type = int, default = 32, help = 'screen height, as SSD1306_HEIGHT')
+    parser.add_argument('--rle', action = 'store_true', help = 'run-length encoded, for rle_upload_bitmap')
     parser.add_argument('input_path')
 
     args = parser.parse_args()
+    if args.height % 8 != 0:
+        parser.error('the height should be a multiple of 8')
 
-    # Load the input as gray scale
-    img = skimage.io.imread(args.input_path, as_gray = True)
-    
-    # Filter the input to enforce a 1 bit image
-    threshold = skimage.filters.threshold_otsu(img)
-    img = img > threshold
-    
-    # Convertion to a byte array
-    scanline_list = [array.array('B', [0] * img.shape[1]) for i in range(img.shape[0] // 8)]
-    for i in range(img.shape[0]):
-        for j in range(img.shape[1]):
-            if img[i][j]:
-                scanline_list[i // 8][j] |= 1 << (i % 8) 
-
-    # Generate C code
+    img = load_picture(args.input_path)
+    if img.shape != (args.height, args.width):
+        print(f'warning: {img.shape[1]}x{img.shape[0]} picture on a {args.width}x{args.height} screen, centered', file = sys.stderr)
+    data = to_pages(img, args.width, args.height)
+
+    size = 'SSD1306_BUFFER_SIZE'
+    if args.rle:
+        raw_size = len(data)
+        data = rle_encode(data)
+        assert rle_decode(data, raw_size) == to_pages(img, args.width, args.height)
+        size = len(data)
+        print(f'{raw_size} bytes, {size} bytes encoded, {100 * size / raw_size:.1f}%', file = sys.stderr)
+
+    # Generate C code, checked against the geometry the driver is built for
     print('#include <stdint.h>')
-    print('const __flash uint8_t') 
-    print(f'{args.array_name}[{img.shape[0] * img.shape[1] // 8}] = {{')
-    print(', '.join(f'0x{byte:02x}'for byte in itertools.chain(*scanline_list)))
-    print('};')                
+    print('#include "ssd1306.h"')
+    print(f'_Static_assert((SSD1306_WIDTH == {args.width}) && (SSD1306_HEIGHT == {args.height}), "bitmap generated for a {args.width}x{args.height} screen");')
+    print('const __flash uint8_t')
+    print(f'{args.array_name}[{size}] = {{')
+    print(', '.join(f'0x{byte:02x}'for byte in data))
+    print('};')
+
 
-    
 if __name__ == "__main__":
     main()
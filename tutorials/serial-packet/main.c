@@ -0,0 +1,92 @@
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+
+#include <string.h>
+
+#include "packet.h"
+#include "uart.h"
+
+
+// --- Packet types -----------------------------------------------------------
+//
+// Answers have the request's type with the highest bit set
+
+#define TYPE_PING   0x01 // Answered with the same payload
+#define TYPE_STATUS 0x02 // Answered with the reception error counters
+#define TYPE_LED    0x03 // Switch the on-board led on or off, 1 byte
+#define TYPE_NACK   0x7f // Unknown or malformed request, payload is its type
+
+#define TYPE_ANSWER 0x80
+
+
+static void
+nack(const struct packet* packet) {
+	packet_send(TYPE_NACK, &packet->type, 1);
+}
+
+
+static void
+on_ping(const struct packet* packet) {
+	packet_send(TYPE_PING | TYPE_ANSWER, packet->payload, packet->length);
+}
+
+
+static void
+on_status(const struct packet* packet) {
+	// Both structures are 16 bits counters, sent little endian
+	struct {
+		struct uart_errors uart;
+		struct packet_errors packet;
+	} status;
+
+	uart_get_errors(&status.uart);
+	packet_get_errors(&status.packet);
+	packet_send(TYPE_STATUS | TYPE_ANSWER, &status, sizeof(status));
+}
+
+
+static void
+on_led(const struct packet* packet) {
+	if (packet->length != 1) {
+		nack(packet);
+		return;
+	}
+
+	if (packet->payload[0])
+		PORTB |= _BV(PORTB5);
+	else
+		PORTB &= ~_BV(PORTB5);
+
+	packet_send(TYPE_LED | TYPE_ANSWER, packet->payload, 1);
+}
+
+
+static const __flash struct packet_handler handlers[] = {
+	{ TYPE_PING,   on_ping },
+	{ TYPE_STATUS, on_status },
+	{ TYPE_LED,    on_led },
+};
+
+
+// --- Main entry point -------------------------------------------------------
+
+int
+main(void) {
+	// On-board led as output
+	DDRB |= _BV(DDB5);
+
+	// UART setup, every byte received goes to the packet decoder
+	uart_init();
+	packet_init();
+	sei();
+
+	// Main loop, only woken up when a whole packet is there
+	while(1) {
+		struct packet packet;
+		packet_receive(&packet);
+
+		if (!packet_dispatch(&packet, handlers, sizeof(handlers) / sizeof(handlers[0])))
+			nack(&packet);
+	}
+}
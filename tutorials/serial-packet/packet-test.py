@@ -0,0 +1,63 @@
+import os
+import sys
+import time
+import random
+import struct
+import argparse
+import serial
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'common'))
+import packet
+
+
+TYPE_PING = 0x01
+TYPE_STATUS = 0x02
+TYPE_LED = 0x03
+TYPE_ANSWER = 0x80
+
+
+def main():
+    # Command line arguments
+    parser = argparse.ArgumentParser(description = 'Exchange packets with the serial-packet firmware')
+    parser.add_argument('--port', default = '/dev/ttyUSB0')
+    parser.add_argument('--baud', type = int, default = 9600)
+    parser.add_argument('--count', type = int, default = 100, help = 'number of pings')
+
+    args = parser.parse_args()
+
+    with serial.Serial(args.port, args.baud, timeout = .05) as port:
+        # Opening the port resets the Arduino
+        time.sleep(2.)
+        port.reset_input_buffer()
+        link = packet.Link(port)
+
+        # Pings with random payloads, zeros included, must come back unchanged
+        lost, wrong, elapsed = 0, 0, 0.
+        for i in range(args.count):
+            payload = bytes(random.choice((0, random.randrange(256))) for _ in range(random.randrange(packet.MAX_PAYLOAD + 1)))
+            start = time.monotonic()
+            link.send(TYPE_PING, payload)
+            answer = link.receive(1.)
+            elapsed += time.monotonic() - start
+            if answer is None:
+                lost += 1
+            elif answer != (TYPE_PING | TYPE_ANSWER, payload):
+                wrong += 1
+            link.send(TYPE_LED, bytes([i & 1]))
+            link.receive(1.)
+
+        print(f'{args.count} pings : {lost} lost, {wrong} wrong, {link.errors} corrupted, '
+              f'{1000. * elapsed / args.count:.1f} msec round trip on average')
+
+        # Error counters of the device
+        link.send(TYPE_STATUS)
+        answer = link.receive(1.)
+        if answer is None or answer[0] != TYPE_STATUS | TYPE_ANSWER:
+            raise RuntimeError('no answer to the STATUS request')
+        frame, overrun, dropped, crc, overflow, packet_dropped = struct.unpack('<6H', answer[1])
+        print(f'device : frame errors {frame}, overruns {overrun}, dropped bytes {dropped}, '
+              f'CRC errors {crc}, overflows {overflow}, dropped packets {packet_dropped}')
+
+
+if __name__ == "__main__":
+    main()
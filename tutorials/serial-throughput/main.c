@@ -0,0 +1,106 @@
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/interrupt.h>
+#include <util/delay.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "baud.h"
+#include "uart.h"
+
+
+// --- Test patterns ----------------------------------------------------------
+
+// Byte i of a test pattern is i modulo 256
+#define BLOCK_SIZE 64
+static uint8_t block[BLOCK_SIZE];
+
+// A reception test ends after that long without receiving anything
+#define RX_IDLE_TIMEOUT_MS 200
+
+
+static void
+send_pattern(uint32_t count) {
+	uint8_t value = 0;
+	while(count != 0) {
+		uint8_t size = (count > BLOCK_SIZE) ? BLOCK_SIZE : count;
+		for(uint8_t i = 0; i < size; ++i)
+			block[i] = value++;
+
+		uart_write(block, size);
+		count -= size;
+	}
+
+	uart_flush();
+}
+
+
+static void
+receive_pattern(uint32_t count) {
+	uint32_t received = 0;
+	uint32_t mismatches = 0;
+	uint8_t expected = 0;
+
+	struct uart_errors errors;
+	uart_get_errors(&errors);
+
+	// Check the pattern, resynchronize on each mismatch
+	fputs("GO\r\n", &uart_output);
+	for(uint16_t idle = 0; (received < count) && (idle < RX_IDLE_TIMEOUT_MS * 10); ) {
+		uint16_t size = uart_try_read(block, BLOCK_SIZE);
+		if (size == 0) {
+			_delay_us(100);
+			idle += 1;
+			continue;
+		}
+
+		for(uint8_t i = 0; i < size; ++i, ++expected) {
+			if (block[i] != expected) {
+				mismatches += 1;
+				expected = block[i];
+			}
+		}
+
+		received += size;
+		idle = 0;
+	}
+
+	// Report
+	uart_get_errors(&errors);
+	fprintf(&uart_output, "RX %lu %lu %u %u %u\r\n",
+		received,
+		mismatches,
+		errors.frame_errors,
+		errors.data_overruns,
+		errors.dropped);
+}
+
+
+// --- Main entry point -------------------------------------------------------
+
+#define LINE_BUFFER_SIZE 32
+
+int
+main(void) {
+	char line[LINE_BUFFER_SIZE];
+
+	// UART setup, at BAUD until the host asks for another rate
+	uart_init();
+	sei();
+
+	// Main loop, one command per line
+	fputs("---[ Arduino serial throughput ]---\r\n", &uart_output);
+	while(1) {
+		fgets(line, LINE_BUFFER_SIZE, &uart_input);
+
+		if (baud_handle_request(line))
+			continue;
+
+		if (strncmp(line, "TX ", 3) == 0)
+			send_pattern(strtoul(line + 3, NULL, 10));
+		else if (strncmp(line, "RX ", 3) == 0)
+			receive_pattern(strtoul(line + 3, NULL, 10));
+	}
+}
@@ -0,0 +1,127 @@
+import time
+import argparse
+import serial
+
+
+INITIAL_BAUD = 9600
+
+
+def read_line(port, timeout):
+    # Read a line, stripped of its end of line, or None after timeout seconds
+    deadline = time.monotonic() + timeout
+    line = bytearray()
+    while time.monotonic() < deadline:
+        c = port.read(1)
+        if not c:
+            continue
+        if c == b'\n':
+            return line.decode('ascii', errors = 'replace').strip()
+        line += c
+    return None
+
+
+def wait_for(port, prefix, timeout):
+    # Read lines until one starts with prefix
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        line = read_line(port, deadline - time.monotonic())
+        if line is not None and line.startswith(prefix):
+            return line
+    return None
+
+
+def negotiate(port, baud):
+    port.reset_input_buffer()
+    port.write(f'BAUD {baud}\n'.encode('ascii'))
+    answer = wait_for(port, ('OK', 'ERR'), 2.)
+    if answer is None:
+        raise RuntimeError('no answer to the BAUD request')
+    if answer.startswith('ERR'):
+        raise RuntimeError(f'rate refused by the device : {answer}')
+    error = int(answer.split()[2]) / 10.
+
+    # Switch, then send SYNC until the device answers
+    port.baudrate = baud
+    for attempt in range(10):
+        port.reset_input_buffer()
+        port.write(b'SYNC\n')
+        if wait_for(port, 'SYNC', .1) is not None:
+            return error
+    raise RuntimeError('no SYNC answer at the new rate')
+
+
+def pattern(size):
+    return bytes(i % 256 for i in range(size))
+
+
+def test_device_to_host(port, size):
+    port.reset_input_buffer()
+    port.write(f'TX {size}\n'.encode('ascii'))
+
+    # Timing starts with the first byte received
+    data = bytearray(port.read(1))
+    start = time.monotonic()
+    while len(data) < size:
+        chunk = port.read(size - len(data))
+        if not chunk:
+            break
+        data += chunk
+    elapsed = time.monotonic() - start
+
+    mismatches = sum(1 for a, b in zip(data, pattern(size)) if a != b)
+    return len(data), mismatches, (len(data) - 1) / elapsed if elapsed > 0 else 0.
+
+
+def test_host_to_device(port, size):
+    port.reset_input_buffer()
+    port.write(f'RX {size}\n'.encode('ascii'))
+    if wait_for(port, 'GO', 2.) is None:
+        raise RuntimeError('no answer to the RX request')
+
+    start = time.monotonic()
+    port.write(pattern(size))
+    port.flush()
+    elapsed = time.monotonic() - start
+
+    answer = wait_for(port, 'RX', 2.)
+    if answer is None:
+        raise RuntimeError('no report for the RX test')
+    received, mismatches, frame_errors, overruns, dropped = (int(v) for v in answer.split()[1:])
+    return received, mismatches, frame_errors, overruns, dropped, size / elapsed
+
+
+def main():
+    # Command line arguments
+    parser = argparse.ArgumentParser(description = 'Measure the sustained throughput and error rate of the serial link with the serial-throughput firmware')
+    parser.add_argument('--port', default = '/dev/ttyUSB0')
+    parser.add_argument('--size', type = int, default = 65536, help = 'bytes per test')
+    parser.add_argument('baud', type = int, nargs = '+', help = 'rates to test')
+
+    args = parser.parse_args()
+
+    # Opening the port resets the Arduino, wait for the banner
+    with serial.Serial(args.port, INITIAL_BAUD, timeout = .5) as port:
+        if wait_for(port, '---[', 5.) is None:
+            raise RuntimeError('no banner from the device, is the firmware uploaded ?')
+
+        for baud in args.baud:
+            error = negotiate(port, baud)
+            print(f'--- {baud} baud, setting error {error:+.1f}% ---')
+
+            received, mismatches, bytes_per_sec = test_device_to_host(port, args.size)
+            lost = args.size - received
+            print(f'device -> host : {bytes_per_sec:9.0f} bytes/s, {bytes_per_sec * 10 / baud:5.1%} of the link, '
+                  f'{lost} lost, {mismatches} wrong, error rate {(lost + mismatches) / args.size:.2e}')
+
+            received, mismatches, frame_errors, overruns, dropped, bytes_per_sec = test_host_to_device(port, args.size)
+            lost = args.size - received
+            print(f'host -> device : {bytes_per_sec:9.0f} bytes/s, {bytes_per_sec * 10 / baud:5.1%} of the link, '
+                  f'{lost} lost, {mismatches} wrong, error rate {(lost + mismatches) / args.size:.2e} '
+                  f'(frame errors {frame_errors}, overruns {overruns}, dropped {dropped})')
+
+            # Back to the initial rate, so that the next test starts from a known state
+            negotiate(port, INITIAL_BAUD)
+
+
+if __name__ == "__main__":
+    main()